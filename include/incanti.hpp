@@ -2,11 +2,90 @@
 #define INCANTI_HPP
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <iostream>
-#include <map>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <optional>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define INCANTI_HAS_MMAP 1
+#else
+#include <fstream>
+#define INCANTI_HAS_MMAP 0
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ConfigWatcher waits on inotify where there is one and polls otherwise
+#ifndef INCANTI_HAS_INOTIFY
+#if defined(__linux__) && __has_include(<sys/inotify.h>)
+#define INCANTI_HAS_INOTIFY 1
+#else
+#define INCANTI_HAS_INOTIFY 0
+#endif
+#endif
+#if INCANTI_HAS_INOTIFY
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#if defined(_WIN32)
+#include <stdlib.h>
+#define INCANTI_ENVIRON _environ
+#else
+extern "C" char **environ;
+#define INCANTI_ENVIRON environ
+#endif
+
+// -fno-exceptions builds: try_parse() works, everything that would throw
+// prints the error and aborts instead
+#ifndef INCANTI_EXCEPTIONS
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define INCANTI_EXCEPTIONS 1
+#else
+#define INCANTI_EXCEPTIONS 0
+#endif
+#endif
+
+// Parser::stats(): registration and parse timings, lookup, token and
+// allocation counters. Off by default, and then none of it is compiled in
+#ifndef INCANTI_STATS
+#define INCANTI_STATS 0
+#endif
 
 /*
  * Rules
@@ -15,9 +94,170 @@
  */
 
 namespace Incanti {
+/* what went wrong in a parse */
+enum class ErrorCode : std::uint8_t {
+  none,
+  unknown_option,        // --nope, -q, or an unknown config key
+  missing_value,         // --threads at the end of the line
+  unexpected_value,      // a value attached to a flag
+  invalid_value,         // a converter rejected the value
+  missing_required,      // a required option was not given
+  unexpected_positional, // struct parsers without a positional list
+  unknown_command,       // a verb no subcommand is registered for
+  unterminated_quote,    // in a command line string or response file
+  file_error,            // a response or config file could not be read
+  config_syntax,         // a malformed config file
+  other                  // a ParseError thrown by user code, API misuse
+};
+
+/*
+ * A failed parse. argv_index is the token the error is in, counted like
+ * argv (the first argument is 1; tokens read from response files continue
+ * the count) and offset the character within that token. Errors that are
+ * not about a token (environment, config files, missing options) have
+ * argv_index -1 and say where they are in the message.
+ */
+struct Error {
+  ErrorCode code = ErrorCode::none;
+  int argv_index = -1;
+  size_t offset = 0;
+  std::string option; // as named in the error, without dashes
+  std::string message;
+  // close matches of an unknown name or value, spelled as they would be
+  // typed (--threshold, -t, fast), closest first
+  std::vector<std::string> suggestions;
+};
+
 class ParseError : public std::runtime_error {
 public:
-  explicit ParseError(const std::string &msg) : std::runtime_error(msg) {}
+  explicit ParseError(const std::string &msg)
+      : std::runtime_error(msg),
+        error_{ErrorCode::other, -1, 0, {}, msg, {}} {}
+  explicit ParseError(Error error)
+      : std::runtime_error(error.message), error_(std::move(error)) {}
+
+  const Error &error() const { return error_; }
+
+private:
+  Error error_;
+};
+
+namespace Detail {
+/* throws, or reports and aborts in builds without exceptions */
+[[noreturn]] inline void raise(const ParseError &error) {
+#if INCANTI_EXCEPTIONS
+  throw error;
+#else
+  std::fprintf(stderr, "incanti: %s\n", error.what());
+  std::abort();
+#endif
+}
+
+#if INCANTI_STATS
+/* counters of the calling thread; a parse reads them before and after */
+struct ThreadCounters {
+  std::uint64_t tokens;
+  std::uint64_t lookups;
+  std::uint64_t allocations;
+  std::uint64_t allocated_bytes;
+};
+
+inline thread_local ThreadCounters thread_counters{};
+
+inline std::uint64_t now_ns() {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+#endif
+
+inline void count_token() {
+#if INCANTI_STATS
+  ++thread_counters.tokens;
+#endif
+}
+
+inline void count_lookup() {
+#if INCANTI_STATS
+  ++thread_counters.lookups;
+#endif
+}
+} // namespace Detail
+
+/*
+ * Feeds Stats::allocations: call it from a replaced operator new. Defining
+ * INCANTI_STATS_COUNT_NEW before including the header in one translation
+ * unit installs such an operator new.
+ */
+inline void note_allocation(size_t bytes) noexcept {
+#if INCANTI_STATS
+  ++Detail::thread_counters.allocations;
+  Detail::thread_counters.allocated_bytes += bytes;
+#else
+  (void)bytes;
+#endif
+}
+
+/* the error side of an Expected */
+struct Unexpected {
+  Error error;
+};
+
+/* lets a converter reject a value without throwing */
+inline Unexpected unexpected(std::string message, size_t offset = 0) {
+  return {Error{ErrorCode::invalid_value, -1, offset, {}, std::move(message),
+                {}}};
+}
+
+/*
+ * A value or the Error that prevented it, after std::expected. Returned by
+ * the try_parse() functions; converters may return one too.
+ */
+template <typename T> class Expected {
+public:
+  Expected(T &&value) : value_(std::move(value)) {}
+  Expected(const T &value) : value_(value) {}
+  Expected(Unexpected failure) : error_(std::move(failure.error)) {}
+
+  bool has_value() const { return value_.has_value(); }
+  explicit operator bool() const { return has_value(); }
+
+  /* raises the error as a ParseError when there is no value */
+  T &value() {
+    if (!value_) {
+      Detail::raise(ParseError(error_));
+    }
+    return *value_;
+  }
+  T &operator*() { return *value_; }
+  const T &operator*() const { return *value_; }
+  T *operator->() { return &*value_; }
+  const T *operator->() const { return &*value_; }
+
+  Error &error() { return error_; }
+  const Error &error() const { return error_; }
+
+private:
+  std::optional<T> value_;
+  Error error_;
+};
+
+template <> class Expected<void> {
+public:
+  Expected() = default;
+  Expected(Unexpected failure)
+      : failed_(true), error_(std::move(failure.error)) {}
+
+  bool has_value() const { return !failed_; }
+  explicit operator bool() const { return has_value(); }
+
+  Error &error() { return error_; }
+  const Error &error() const { return error_; }
+
+private:
+  bool failed_ = false;
+  Error error_;
 };
 
 struct required_t {
@@ -33,498 +273,6903 @@ template <typename T> struct default_wrapper {
 
 struct converter_t {};
 
-template <typename T> struct ArgP {
-  std::string name;
-  std::string short_name;
-  T *value_ptr;
+/* element delimiter of a list argument, '\0' turns splitting off */
+struct delimiter_wrapper {
+  char value;
+};
 
-  ArgP(std::string n, std::string sn, T *p)
-      : name(std::move(n)), short_name(std::move(sn)), value_ptr(p) {}
+/* environment variable an argument falls back to */
+struct env_wrapper {
+  std::string_view name;
 };
 
-struct FlagP {
-  std::string name;
-  std::string short_name;
-  bool *value_ptr;
+/* the only values an argument accepts, also offered by shell completion */
+template <size_t N> struct choices_wrapper {
+  std::array<std::string_view, N> values;
+};
 
-  FlagP(std::string n, std::string sn, bool *p)
-      : name(std::move(n)), short_name(std::move(sn)), value_ptr(p) {}
+/* called with the new value when a ConfigWatcher replaces a Reloadable */
+template <typename F> struct change_wrapper {
+  F callback;
 };
 
-class Argument {
+/* shells Parser::completion_script() writes for */
+enum class Shell : std::uint8_t { bash, zsh, fish };
+
+/* where the value of an argument came from, later layers win */
+enum class Source : std::uint8_t {
+  none,
+  default_value,
+  config,
+  environment,
+  command_line
+};
+
+template <typename T> class Lazy;
+template <typename T> class Reloadable;
+
+namespace Detail {
+template <typename T> struct ListTraits {
+  static constexpr bool is_list = false;
+  using element_type = T;
+};
+
+template <typename E, typename A> struct ListTraits<std::vector<E, A>> {
+  static constexpr bool is_list = true;
+  using element_type = E;
+};
+
+/* Lazy<T> arguments convert a T, see Lazy */
+template <typename T> struct LazyTraits {
+  static constexpr bool is_lazy = false;
+  using value_type = T;
+};
+
+template <typename T> struct LazyTraits<Lazy<T>> {
+  static constexpr bool is_lazy = true;
+  using value_type = T;
+};
+
+/* Reloadable<T> arguments convert a T, see Reloadable */
+template <typename T> struct ReloadableTraits {
+  static constexpr bool is_reloadable = false;
+  using value_type = T;
+};
+
+template <typename T> struct ReloadableTraits<Reloadable<T>> {
+  static constexpr bool is_reloadable = true;
+  using value_type = T;
+};
+
+template <typename T, typename = void>
+struct IsStreamable : std::false_type {};
+
+template <typename T>
+struct IsStreamable<T, std::void_t<decltype(std::declval<std::ostream &>()
+                                            << std::declval<const T &>())>>
+    : std::true_type {};
+
+/* occurrences of c in text, 16 bytes per step where SSE2 is available */
+inline size_t count_char(std::string_view text, char c) {
+  size_t count{0};
+  size_t i{0};
+#if defined(__SSE2__)
+  const __m128i needle = _mm_set1_epi8(c);
+  for (; i + 16 <= text.size(); i += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + i));
+    count += static_cast<size_t>(
+        __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle))));
+  }
+#endif
+  for (; i < text.size(); ++i) {
+    count += text[i] == c;
+  }
+  return count;
+}
+
+inline std::string_view trim_spaces(std::string_view text) {
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+} // namespace Detail
+
+/* 64-bit FNV-1a over a name, finished with a murmur3 avalanche so that
+ * nearby seeds give independent positions. */
+constexpr std::uint64_t hash_name(std::string_view name,
+                                  std::uint64_t seed = 0) noexcept {
+  std::uint64_t h = 0xcbf29ce484222325ull ^ (seed * 0x9e3779b97f4a7c15ull);
+  for (unsigned char c : name) {
+    h ^= c;
+    h *= 0x100000001b3ull;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+/*
+ * Flat perfect-hash index over option names (hash-and-displace).
+ * Keys are grouped into buckets by their hash, and every bucket gets a seed
+ * which moves its keys onto free table positions. A lookup is one hash of
+ * the name, one seed read and one probe with a final name compare.
+ */
+class OptionIndex {
+public:
+  enum class Kind : std::uint8_t { long_name, short_name };
+
+  struct Key {
+    std::string_view name;
+    Kind kind;
+    std::uint32_t slot;
+  };
+
+  static constexpr std::uint32_t npos = 0xffffffffu;
+
+  void build(const std::vector<Key> &keys) {
+    size_t table_size = 1;
+    while (table_size < keys.size() + keys.size() / 4 + 1) {
+      table_size <<= 1;
+    }
+    size_t bucket_count = 1;
+    while (bucket_count < keys.size() / 2) {
+      bucket_count <<= 1;
+    }
+
+    std::vector<std::uint64_t> hashes(keys.size());
+    for (size_t k{0}; k < keys.size(); ++k) {
+      hashes[k] = hash_name(keys[k].name, key_seed_(keys[k].kind));
+    }
+
+    /* bigger buckets are placed first, while the table is still empty */
+    std::vector<std::uint32_t> order(keys.size());
+    for (size_t k{0}; k < keys.size(); ++k) {
+      order[k] = static_cast<std::uint32_t>(k);
+    }
+
+    const std::uint64_t bucket_mask = bucket_count - 1;
+    std::sort(order.begin(), order.end(),
+              [&](std::uint32_t a, std::uint32_t b) {
+                return (hashes[a] & bucket_mask) < (hashes[b] & bucket_mask);
+              });
+
+    std::vector<std::pair<size_t, size_t>> buckets; // [begin, end) in order
+    for (size_t b{0}; b < order.size();) {
+      size_t e = b + 1;
+      while (e < order.size() && (hashes[order[e]] & bucket_mask) ==
+                                     (hashes[order[b]] & bucket_mask)) {
+        ++e;
+      }
+      buckets.emplace_back(b, e);
+      b = e;
+    }
+    std::stable_sort(buckets.begin(), buckets.end(),
+                     [](const auto &a, const auto &b) {
+                       return a.second - a.first > b.second - b.first;
+                     });
+
+    // identical keys can never be separated, so the table growth is bounded
+    const size_t max_table_size = 64 * (keys.size() + 1);
+    for (; table_size <= max_table_size; table_size <<= 1) {
+      if (place_(keys, hashes, order, buckets, bucket_count, table_size)) {
+        return;
+      }
+    }
+
+    Detail::raise(
+        ParseError("Could not build option index (duplicate option names?)"));
+  }
+
+  std::uint32_t find(Kind kind, std::string_view name) const noexcept {
+    if (entries_.empty()) {
+      return npos;
+    }
+    const std::uint64_t h = hash_name(name, key_seed_(kind));
+    const std::uint32_t seed = seeds_[h & (seeds_.size() - 1)];
+    const Entry &e = entries_[position_(h, seed, entries_.size())];
+    if (e.slot != npos && e.kind == kind && e.name == name) {
+      return e.slot;
+    }
+    return npos;
+  }
+
+  size_t size() const { return size_; }
+
+  /* bytes held by the index tables (names are not owned) */
+  size_t memory_usage() const {
+    return entries_.capacity() * sizeof(Entry) +
+           seeds_.capacity() * sizeof(std::uint32_t);
+  }
+
+private:
+  struct Entry {
+    std::string_view name;
+    std::uint32_t slot = npos;
+    Kind kind = Kind::long_name;
+  };
+
+  std::vector<Entry> entries_;
+  std::vector<std::uint32_t> seeds_;
+  size_t size_ = 0;
+
+  static std::uint64_t key_seed_(Kind kind) {
+    return static_cast<std::uint64_t>(kind) + 1;
+  }
+
+  static size_t position_(std::uint64_t h, std::uint32_t seed,
+                          size_t table_size) {
+    std::uint64_t x = h ^ ((seed + 1) * 0x9e3779b97f4a7c15ull);
+    x ^= x >> 29;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 32;
+    return static_cast<size_t>(x & (table_size - 1));
+  }
+
+  bool place_(const std::vector<Key> &keys,
+              const std::vector<std::uint64_t> &hashes,
+              const std::vector<std::uint32_t> &order,
+              const std::vector<std::pair<size_t, size_t>> &buckets,
+              size_t bucket_count, size_t table_size) {
+    std::vector<Entry> entries(table_size);
+    std::vector<std::uint32_t> seeds(bucket_count, 0);
+    std::vector<size_t> positions;
+    const std::uint32_t max_seed = 1u << 16;
+
+    for (const auto &[begin, end] : buckets) {
+      bool placed{false};
+      for (std::uint32_t seed{0}; seed < max_seed && !placed; ++seed) {
+        positions.clear();
+        placed = true;
+        for (size_t k{begin}; k < end; ++k) {
+          size_t pos = position_(hashes[order[k]], seed, table_size);
+          if (entries[pos].slot != npos ||
+              std::find(positions.begin(), positions.end(), pos) !=
+                  positions.end()) {
+            placed = false;
+            break;
+          }
+          positions.push_back(pos);
+        }
+        if (placed) {
+          seeds[hashes[order[begin]] & (bucket_count - 1)] = seed;
+          for (size_t k{begin}; k < end; ++k) {
+            const Key &key = keys[order[k]];
+            entries[positions[k - begin]] = Entry{key.name, key.slot, key.kind};
+          }
+        }
+      }
+      if (!placed) {
+        return false;
+      }
+    }
+
+    entries_ = std::move(entries);
+    seeds_ = std::move(seeds);
+    size_ = keys.size();
+    return true;
+  }
+};
+
+/*
+ * Short option lookup. Single characters resolve through a 256-entry table,
+ * multi-character short names (like -th) through a compact trie whose
+ * children are stored contiguously per node. Both are linear in the length
+ * of the token and independent of how many options are registered.
+ */
+class ShortIndex {
+public:
+  struct Key {
+    std::string_view name;
+    std::uint32_t slot;
+  };
+
+  static constexpr std::uint32_t npos = OptionIndex::npos;
+
+  ShortIndex() { single_.fill(npos); }
+
+  void build(std::vector<Key> keys) {
+    single_.fill(npos);
+    nodes_.clear();
+    edges_.clear();
+
+    auto multi = std::partition(keys.begin(), keys.end(), [&](const Key &k) {
+      if (k.name.size() == 1) {
+        single_[static_cast<unsigned char>(k.name[0])] = k.slot;
+        return true;
+      }
+      return false;
+    });
+    std::sort(multi, keys.end(), [](const Key &a, const Key &b) {
+      return a.name < b.name;
+    });
+
+    /* breadth first over sorted ranges, so that every node owns one
+     * contiguous run of edges */
+    struct Pending {
+      std::uint32_t node;
+      size_t lo, hi, depth;
+    };
+    std::vector<Pending> queue{{0, static_cast<size_t>(multi - keys.begin()),
+                                keys.size(), 0}};
+    nodes_.push_back({});
+    for (size_t q{0}; q < queue.size(); ++q) {
+      Pending p = queue[q];
+      if (p.lo < p.hi && keys[p.lo].name.size() == p.depth) {
+        nodes_[p.node].slot = keys[p.lo].slot;
+        ++p.lo;
+      }
+      nodes_[p.node].first_edge = static_cast<std::uint32_t>(edges_.size());
+      for (size_t lo{p.lo}; lo < p.hi;) {
+        const char c = keys[lo].name[p.depth];
+        size_t hi = lo + 1;
+        while (hi < p.hi && keys[hi].name[p.depth] == c) {
+          ++hi;
+        }
+        auto child = static_cast<std::uint32_t>(nodes_.size());
+        nodes_.push_back({});
+        edges_.push_back({c, child});
+        queue.push_back({child, lo, hi, p.depth + 1});
+        lo = hi;
+      }
+      nodes_[p.node].edge_count =
+          static_cast<std::uint32_t>(edges_.size()) - nodes_[p.node].first_edge;
+    }
+  }
+
+  std::uint32_t find_char(char c) const {
+    return single_[static_cast<unsigned char>(c)];
+  }
+
+  std::uint32_t find(std::string_view name) const {
+    if (name.size() == 1) {
+      return find_char(name[0]);
+    }
+    std::uint32_t node{0};
+    for (char c : name) {
+      node = child_(node, c);
+      if (node == npos) {
+        return npos;
+      }
+    }
+    return nodes_[node].slot;
+  }
+
+  /* longest multi-character name that is a strict prefix of token, its
+   * length goes to length */
+  std::uint32_t longest_prefix(std::string_view token, size_t &length) const {
+    std::uint32_t best = npos;
+    std::uint32_t node{0};
+    for (size_t d{0}; d + 1 < token.size(); ++d) {
+      node = child_(node, token[d]);
+      if (node == npos) {
+        break;
+      }
+      if (d >= 1 && nodes_[node].slot != npos) {
+        best = nodes_[node].slot;
+        length = d + 1;
+      }
+    }
+    return best;
+  }
+
+  size_t memory_usage() const {
+    return sizeof(single_) + nodes_.capacity() * sizeof(Node) +
+           edges_.capacity() * sizeof(Edge);
+  }
+
+private:
+  struct Node {
+    std::uint32_t first_edge = 0;
+    std::uint32_t edge_count = 0;
+    std::uint32_t slot = npos;
+  };
+  struct Edge {
+    char c;
+    std::uint32_t node;
+  };
+
+  std::array<std::uint32_t, 256> single_;
+  std::vector<Node> nodes_;
+  std::vector<Edge> edges_;
+
+  std::uint32_t child_(std::uint32_t node, char c) const {
+    if (nodes_.empty()) {
+      return npos;
+    }
+    const Node &n = nodes_[node];
+    for (std::uint32_t e{n.first_edge}; e < n.first_edge + n.edge_count; ++e) {
+      if (edges_[e].c == c) {
+        return edges_[e].node;
+      }
+    }
+    return npos;
+  }
+};
+
+namespace Detail {
+/*
+ * Prefix queries for shell completion: every option spelling (--name, -s)
+ * in byte order, so the matches of a prefix are one binary search and a
+ * run of neighbours. Allowed values are kept sorted per slot the same way.
+ */
+class CompletionIndex {
 public:
-  virtual ~Argument() = default;
-  virtual void parse(const std::string &value) = 0;
-  virtual bool has_value() const = 0;
-  virtual std::string get_help() const = 0;
-  virtual bool is_required() const = 0;
-  virtual std::string get_name() const = 0;
+  void clear() {
+    text_.clear();
+    spellings_.clear();
+    values_.clear();
+    value_ranges_.clear();
+  }
+
+  void add_option(std::string_view dashes, std::string_view name,
+                  std::uint32_t slot) {
+    const auto begin = static_cast<std::uint32_t>(text_.size());
+    text_.append(dashes).append(name);
+    spellings_.push_back(
+        {begin, static_cast<std::uint32_t>(text_.size() - begin), slot});
+  }
+
+  /* values must outlive the index (they are the arena's) */
+  void add_values(std::uint32_t slot, const std::string_view *values,
+                  size_t count) {
+    if (value_ranges_.size() <= slot) {
+      value_ranges_.resize(slot + 1, {0, 0});
+    }
+    const auto begin = static_cast<std::uint32_t>(values_.size());
+    values_.insert(values_.end(), values, values + count);
+    std::sort(values_.begin() + begin, values_.end());
+    value_ranges_[slot] = {begin, static_cast<std::uint32_t>(values_.size())};
+  }
+
+  void finish() {
+    std::sort(spellings_.begin(), spellings_.end(),
+              [this](const Spelling &a, const Spelling &b) {
+                return view_(a) < view_(b);
+              });
+  }
+
+  /* f(spelling, slot) for every option starting with prefix, in order */
+  template <typename F> void options(std::string_view prefix, F &&f) const {
+    auto it = std::lower_bound(spellings_.begin(), spellings_.end(), prefix,
+                               [this](const Spelling &s, std::string_view p) {
+                                 return view_(s) < p;
+                               });
+    for (; it != spellings_.end(); ++it) {
+      std::string_view spelling = view_(*it);
+      if (spelling.substr(0, prefix.size()) != prefix) {
+        break;
+      }
+      f(spelling, it->slot);
+    }
+  }
+
+  /* f(value) for every allowed value of slot starting with prefix */
+  template <typename F>
+  void values(std::uint32_t slot, std::string_view prefix, F &&f) const {
+    if (slot >= value_ranges_.size()) {
+      return;
+    }
+    auto first = values_.begin() + value_ranges_[slot].first;
+    auto last = values_.begin() + value_ranges_[slot].second;
+    for (auto it = std::lower_bound(first, last, prefix);
+         it != last && it->substr(0, prefix.size()) == prefix; ++it) {
+      f(*it);
+    }
+  }
+
+  size_t memory_usage() const {
+    return text_.capacity() + spellings_.capacity() * sizeof(Spelling) +
+           values_.capacity() * sizeof(std::string_view) +
+           value_ranges_.capacity() *
+               sizeof(std::pair<std::uint32_t, std::uint32_t>);
+  }
+
+private:
+  struct Spelling {
+    std::uint32_t begin; // in text_
+    std::uint32_t size;
+    std::uint32_t slot;
+  };
+
+  std::string text_;
+  std::vector<Spelling> spellings_;
+  std::vector<std::string_view> values_;
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> value_ranges_;
+
+  std::string_view view_(const Spelling &s) const {
+    return std::string_view(text_.data() + s.begin, s.size);
+  }
+};
+} // namespace Detail
+
+/*
+ * Numeric conversion
+ * Locale-free, built on std::from_chars. The whole input has to be consumed.
+ * Accepts an optional sign, 0x / 0o / 0b prefixes (hex floats too) and '_'
+ * or '\'' separators between digits: 0xff_ff, 1'000'000, -0b1010.
+ */
+enum class ConvertErrc : std::uint8_t {
+  ok,
+  empty,
+  invalid,
+  trailing,
+  out_of_range,
+  negative,
+};
+
+struct NumberResult {
+  ConvertErrc ec = ConvertErrc::ok;
+  size_t offset = 0; // first offending character in the input
+
+  explicit operator bool() const { return ec == ConvertErrc::ok; }
+};
+
+namespace Detail {
+inline int digit_value(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'z')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A' + 10;
+  return 99;
+}
+
+inline bool is_separator(char c) { return c == '_' || c == '\''; }
+
+/* sign and base prefix, returns the offset where digits start */
+inline size_t number_prefix(std::string_view text, bool &negative, int &base) {
+  size_t pos{0};
+  negative = false;
+  base = 10;
+  if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+    negative = text[pos] == '-';
+    ++pos;
+  }
+  if (pos + 1 < text.size() && text[pos] == '0') {
+    char p = static_cast<char>(text[pos + 1] | 0x20);
+    if (p == 'x' || p == 'o' || p == 'b') {
+      base = p == 'x' ? 16 : p == 'o' ? 8 : 2;
+      pos += 2;
+    }
+  }
+  return pos;
+}
+} // namespace Detail
+
+template <typename T>
+NumberResult parse_number(std::string_view text, T &out) noexcept {
+  static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>,
+                "parse_number needs an arithmetic type");
+  if (text.empty()) {
+    return {ConvertErrc::empty, 0};
+  }
+
+  bool negative;
+  int base;
+  const size_t digits_at = Detail::number_prefix(text, negative, base);
+  if constexpr (std::is_unsigned_v<T>) {
+    if (negative) {
+      return {ConvertErrc::negative, 0};
+    }
+  }
+
+  // plain decimal input goes straight to from_chars over the caller's text
+  if (base == 10 && digits_at < text.size() && text[digits_at] != '-' &&
+      text[digits_at] != '+') {
+    const char *end = text.data() + text.size();
+    const char *begin = text.data() + digits_at - (negative ? 1 : 0);
+    T value{};
+    auto r = std::from_chars(begin, end, value);
+    if (r.ec == std::errc() && r.ptr == end) {
+      out = value;
+      return {};
+    }
+  }
+
+  /* copy the digits without separators; a separator must sit between two
+   * digits. Anything that is not part of the number ends the copy. */
+  char buf[128];
+  size_t len{0};
+  if (negative) {
+    buf[len++] = '-';
+  }
+  const size_t first = len;
+  size_t pos{digits_at};
+  for (; pos < text.size(); ++pos) {
+    char c = text[pos];
+    if (Detail::is_separator(c)) {
+      if (pos == digits_at || pos + 1 >= text.size() ||
+          Detail::digit_value(text[pos - 1]) >= base ||
+          Detail::digit_value(text[pos + 1]) >= base) {
+        return {ConvertErrc::invalid, pos};
+      }
+      continue;
+    }
+    bool part_of_number;
+    if constexpr (std::is_integral_v<T>) {
+      part_of_number = Detail::digit_value(c) < base;
+    } else {
+      char l = static_cast<char>(c | 0x20);
+      part_of_number =
+          Detail::digit_value(c) < base || c == '.' ||
+          (base == 10 && (l == 'e' || l == 'i' || l == 'n' || l == 'f' ||
+                          l == 't' || l == 'y' || l == 'a' ||
+                          ((c == '+' || c == '-') && len > first &&
+                           (buf[len - 1] | 0x20) == 'e'))) ||
+          (base == 16 && (l == 'p' || ((c == '+' || c == '-') && len > first &&
+                                       (buf[len - 1] | 0x20) == 'p')));
+    }
+    if (!part_of_number) {
+      break;
+    }
+    if (len == sizeof(buf)) {
+      return {ConvertErrc::out_of_range, digits_at};
+    }
+    buf[len++] = c;
+  }
+
+  if (len == first) {
+    return {ConvertErrc::invalid, digits_at};
+  }
+
+  std::from_chars_result r;
+  if constexpr (std::is_integral_v<T>) {
+    r = std::from_chars(buf, buf + len, out, base);
+  } else {
+    if (base == 8 || base == 2) {
+      return {ConvertErrc::invalid, digits_at - 2};
+    }
+    r = std::from_chars(buf, buf + len, out,
+                        base == 16 ? std::chars_format::hex
+                                   : std::chars_format::general);
+  }
+
+  if (r.ec == std::errc::invalid_argument) {
+    return {ConvertErrc::invalid, digits_at};
+  }
+  if (r.ec == std::errc::result_out_of_range) {
+    return {ConvertErrc::out_of_range, digits_at};
+  }
+  if (r.ptr != buf + len) {
+    // from_chars stopped early inside the copied run, e.g. "1.2.3"
+    size_t consumed = static_cast<size_t>(r.ptr - buf) - first;
+    size_t at = digits_at;
+    for (size_t seen{0}; at < text.size() && seen < consumed; ++at) {
+      if (!Detail::is_separator(text[at])) {
+        ++seen;
+      }
+    }
+    return {ConvertErrc::trailing, at};
+  }
+  if (pos != text.size()) {
+    return {ConvertErrc::trailing, pos};
+  }
+  return {};
+}
+
+/* a number of bytes, given as 4GiB, 512M or 1.5MB; see parse_byte_size() */
+struct ByteSize {
+  std::uint64_t bytes = 0;
+
+  constexpr ByteSize() = default;
+  constexpr ByteSize(std::uint64_t count) : bytes(count) {}
+  constexpr operator std::uint64_t() const { return bytes; }
 };
 
-template <typename T> class TypedArgument : public Argument {
-public:
-  TypedArgument(const std::string &name, const std::string &short_name,
-                T *value_ptr)
-      : name_(name), short_name_(short_name), value_ptr_(value_ptr),
-        required_(false), has_default_(false), parsed_(false) {
-    str_to_T_ = [this](const std::string &s) { return converter_(s); };
+/*
+ * A set of CPU numbers, given as 0-3,8-11 or 0-15:2. The words have the
+ * layout of Linux's cpu_set_t (CPU_SETSIZE bits of unsigned long, on
+ * 64-bit and little endian targets), so a set can be handed straight to
+ * sched_setaffinity(0, set.size_bytes(),
+ *                   reinterpret_cast<const cpu_set_t *>(set.data())).
+ */
+class CpuSet {
+public:
+  static constexpr size_t max_cpus = 1024;
+
+  bool test(size_t cpu) const {
+    return cpu < max_cpus && (words_[cpu / 64] >> (cpu % 64) & 1);
+  }
+  /* a cpu past max_cpus is ignored, as test() reports it off */
+  void set(size_t cpu, bool on = true) {
+    if (cpu >= max_cpus) {
+      return;
+    }
+    const std::uint64_t bit = std::uint64_t{1} << (cpu % 64);
+    words_[cpu / 64] = on ? words_[cpu / 64] | bit : words_[cpu / 64] & ~bit;
+  }
+  size_t count() const {
+    size_t n{0};
+    for (std::uint64_t w : words_) {
+      for (; w; w &= w - 1) {
+        ++n;
+      }
+    }
+    return n;
+  }
+  bool empty() const { return count() == 0; }
+
+  const std::uint64_t *data() const { return words_.data(); }
+  static constexpr size_t size_bytes() { return max_cpus / 8; }
+
+  bool operator==(const CpuSet &other) const {
+    return words_ == other.words_;
+  }
+  bool operator!=(const CpuSet &other) const { return !(*this == other); }
+
+private:
+  std::array<std::uint64_t, max_cpus / 64> words_{};
+};
+
+/* an inclusive range of integers, given as 9000-9010 or a single 9000 */
+template <typename T> struct Range {
+  static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                "Range needs an integer type");
+  using value_type = T;
+
+  T first{};
+  T last{};
+
+  constexpr Range() = default;
+  constexpr Range(T value) : first(value), last(value) {}
+  constexpr Range(T from, T to) : first(from), last(to) {}
+
+  constexpr bool contains(T value) const {
+    return first <= value && value <= last;
+  }
+  /* the number of values, 0 when it does not fit (the whole of uint64) */
+  constexpr std::uint64_t size() const {
+    using U = std::make_unsigned_t<T>;
+    return std::uint64_t{static_cast<U>(static_cast<U>(last) -
+                                        static_cast<U>(first))} +
+           1;
+  }
+  constexpr bool operator==(const Range &other) const {
+    return first == other.first && last == other.last;
+  }
+  constexpr bool operator!=(const Range &other) const {
+    return !(*this == other);
+  }
+};
+
+namespace Detail {
+template <typename T> struct IsDuration : std::false_type {};
+template <typename R, typename P>
+struct IsDuration<std::chrono::duration<R, P>> : std::true_type {};
+
+template <typename T> struct IsRange : std::false_type {};
+template <typename T> struct IsRange<Range<T>> : std::true_type {};
+} // namespace Detail
+
+template <typename T> std::string type_name() {
+  if constexpr (std::is_same_v<T, char>)
+    return "char";
+  else if constexpr (std::is_same_v<T, signed char>)
+    return "int8_t";
+  else if constexpr (std::is_same_v<T, unsigned char>)
+    return "uint8_t";
+  else if constexpr (std::is_same_v<T, short>)
+    return "short";
+  else if constexpr (std::is_same_v<T, unsigned short>)
+    return "unsigned short";
+  else if constexpr (std::is_same_v<T, int>)
+    return "int";
+  else if constexpr (std::is_same_v<T, unsigned>)
+    return "unsigned";
+  else if constexpr (std::is_same_v<T, long>)
+    return "long";
+  else if constexpr (std::is_same_v<T, unsigned long>)
+    return "unsigned long";
+  else if constexpr (std::is_same_v<T, long long>)
+    return "long long";
+  else if constexpr (std::is_same_v<T, unsigned long long>)
+    return "unsigned long long";
+  else if constexpr (std::is_same_v<T, float>)
+    return "float";
+  else if constexpr (std::is_same_v<T, double>)
+    return "double";
+  else if constexpr (std::is_same_v<T, long double>)
+    return "long double";
+  else if constexpr (std::is_same_v<T, ByteSize>)
+    return "byte size";
+  else if constexpr (std::is_same_v<T, CpuSet>)
+    return "CPU set";
+  else if constexpr (Detail::IsDuration<T>::value)
+    return "duration";
+  else if constexpr (Detail::IsRange<T>::value)
+    return "range";
+  else
+    return "value";
+}
+
+/* human readable reason for a failed parse_number<T>() */
+template <typename T>
+std::string number_error(std::string_view text, NumberResult r) {
+  switch (r.ec) {
+  case ConvertErrc::ok:
+    return {};
+  case ConvertErrc::empty:
+    return "empty value";
+  case ConvertErrc::invalid:
+    return "not a valid " + type_name<T>() + " (at offset " +
+           std::to_string(r.offset) + ")";
+  case ConvertErrc::trailing:
+    return "unexpected trailing characters '" +
+           std::string(text.substr(r.offset)) + "'";
+  case ConvertErrc::negative:
+    return "negative value for " + type_name<T>();
+  case ConvertErrc::out_of_range:
+    if constexpr (std::is_integral_v<T>) {
+      return "out of range for " + type_name<T>() + " [" +
+             std::to_string(+std::numeric_limits<T>::min()) + ", " +
+             std::to_string(+std::numeric_limits<T>::max()) + "]";
+    } else {
+      return "out of range for " + type_name<T>();
+    }
+  }
+  return {};
+}
+
+namespace Detail {
+inline bool iequals(std::string_view a, std::string_view b) {
+  return a.size() == b.size() &&
+         std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+           return ::tolower(static_cast<unsigned char>(x)) == y;
+         });
+}
+
+inline bool boolify(std::string_view str, bool &out) {
+  if (iequals(str, "true") || str == "1" || iequals(str, "yes")) {
+    out = true;
+    return true;
+  }
+  if (iequals(str, "false") || str == "0" || iequals(str, "no")) {
+    out = false;
+    return true;
+  }
+  return false;
+}
+
+/* decimal digits with an optional .fraction from text[pos], as a mantissa
+ * and the number of fraction digits ("1.25" is 125 and 2); pos ends after
+ * them. ConvertErrc::invalid without digits, out_of_range past 64 bits */
+inline ConvertErrc scan_decimal(std::string_view text, size_t &pos,
+                                std::uint64_t &mantissa, unsigned &scale) {
+  mantissa = 0;
+  scale = 0;
+  size_t digits{0};
+  bool fraction{false};
+  for (; pos < text.size(); ++pos) {
+    const char c = text[pos];
+    if (c == '.' && !fraction) {
+      fraction = true;
+      continue;
+    }
+    if (c < '0' || c > '9') {
+      break;
+    }
+    const unsigned digit = static_cast<unsigned>(c - '0');
+    if (mantissa > (std::numeric_limits<std::uint64_t>::max() - digit) / 10 ||
+        scale == 19) {
+      return ConvertErrc::out_of_range;
+    }
+    mantissa = mantissa * 10 + digit;
+    scale += fraction;
+    ++digits;
+  }
+  return digits ? ConvertErrc::ok : ConvertErrc::invalid;
+}
+
+/* mantissa / 10^scale * num / den as a whole number; invalid when it is
+ * not whole, out_of_range when it does not fit */
+inline ConvertErrc scale_exact(std::uint64_t mantissa, unsigned scale,
+                               std::uint64_t num, std::uint64_t den,
+                               std::uint64_t &out) {
+  std::uint64_t power{1};
+  for (unsigned i{0}; i < scale; ++i) {
+    power *= 10;
+  }
+  // mantissa/power in lowest terms; with num/den reduced as well the
+  // product is whole exactly when power | num and den | mantissa
+  const std::uint64_t g = mantissa ? std::gcd(mantissa, power) : power;
+  mantissa /= g;
+  power /= g;
+  if (num % power != 0 || mantissa % den != 0) {
+    return ConvertErrc::invalid;
+  }
+  const std::uint64_t a = mantissa / den;
+  const std::uint64_t b = num / power;
+  if (b != 0 && a > std::numeric_limits<std::uint64_t>::max() / b) {
+    return ConvertErrc::out_of_range;
+  }
+  out = a * b;
+  return ConvertErrc::ok;
+}
+
+/* a byte size suffix and its multiplier, largest first */
+struct SizeUnit {
+  std::string_view name;
+  std::uint64_t bytes;
+};
+
+inline constexpr SizeUnit size_units[] = {
+    {"EiB", std::uint64_t{1} << 60}, {"EB", 1000000000000000000},
+    {"PiB", std::uint64_t{1} << 50}, {"PB", 1000000000000000},
+    {"TiB", std::uint64_t{1} << 40}, {"TB", 1000000000000},
+    {"GiB", std::uint64_t{1} << 30}, {"GB", 1000000000},
+    {"MiB", std::uint64_t{1} << 20}, {"MB", 1000000},
+    {"KiB", std::uint64_t{1} << 10}, {"kB", 1000}};
+
+/*
+ * 4GiB, 1.5MB, 512K, 100: a number, whole or decimal, and a unit spelled
+ * as SI / IEC do, case and all, except that kilo may be k or K in k and
+ * kB (Mb would be megabits). KiB .. EiB are powers of 1024, kB .. EB
+ * powers of 1000, and a single letter K, M, G, T, P or E is binary as in
+ * dd and sort; B or nothing means bytes. The result must be a whole
+ * number of bytes.
+ */
+inline std::optional<ByteSize> parse_byte_size(std::string_view text,
+                                               Error &error) {
+  size_t pos{0};
+  std::uint64_t mantissa;
+  unsigned scale;
+  const ConvertErrc scanned = scan_decimal(text, pos, mantissa, scale);
+  if (scanned != ConvertErrc::ok) {
+    error.message = text.empty() ? "empty value"
+                    : scanned == ConvertErrc::invalid
+                        ? "expected a number of bytes like 4GiB"
+                        : "out of range for a byte size";
+    return std::nullopt;
+  }
+  const std::string_view given = text.substr(pos);
+  // kilo may be k or K in k and kB only, KiB is always KiB
+  const std::string_view unit = given == "k"    ? std::string_view("K")
+                                : given == "KB" ? std::string_view("kB")
+                                                : given;
+  std::uint64_t multiplier = unit.empty() || unit == "B" ? 1 : 0;
+  for (const SizeUnit &u : size_units) {
+    // KiB, and K for the binary unit
+    if (unit == u.name || (u.name.size() == 3 && unit == u.name.substr(0, 1))) {
+      multiplier = u.bytes;
+      break;
+    }
+  }
+  if (multiplier == 0) {
+    // B, the letters, then the binary and decimal units, smallest first
+    std::string expected = "B";
+    for (int pass{0}; pass < 3; ++pass) {
+      for (size_t i = std::size(size_units); i-- > 0;) {
+        const std::string_view name = size_units[i].name;
+        if ((name.size() == 3) != (pass < 2)) {
+          continue;
+        }
+        expected += ", ";
+        expected += pass == 0 ? name.substr(0, 1) : name;
+      }
+    }
+    expected.replace(expected.rfind(", "), 2, " or ");
+    error.offset = pos;
+    error.message = "unknown size unit '" + std::string(given) +
+                    "', expected " + expected + " (case-sensitive)";
+    return std::nullopt;
+  }
+  std::uint64_t bytes{0};
+  switch (scale_exact(mantissa, scale, multiplier, 1, bytes)) {
+  case ConvertErrc::ok:
+    return ByteSize{bytes};
+  case ConvertErrc::invalid:
+    error.message = "not a whole number of bytes";
+    return std::nullopt;
+  default:
+    error.message = "out of range for a byte size";
+    return std::nullopt;
+  }
+}
+
+/* the shortest exact spelling, a whole number or up to 3 decimals of a
+ * unit, the larger unit on ties: 4GiB, 1.5MB, 1023B */
+inline void write_byte_size(std::ostream &out, std::uint64_t bytes) {
+  char best[32];
+  size_t best_length{0};
+  for (const SizeUnit &u : size_units) {
+    if (bytes < u.bytes) {
+      continue;
+    }
+    const std::uint64_t rest = bytes % u.bytes;
+    const std::uint64_t g = rest ? std::gcd(rest, u.bytes) : u.bytes;
+    if (1000 % (u.bytes / g) != 0) {
+      continue;
+    }
+    char text[32];
+    char *end = std::to_chars(text, text + 20, bytes / u.bytes).ptr;
+    if (rest) {
+      std::uint64_t thousandths = rest / g * (1000 / (u.bytes / g));
+      *end++ = '.';
+      for (std::uint64_t digit = 100; thousandths; digit /= 10) {
+        *end++ = static_cast<char>('0' + thousandths / digit);
+        thousandths %= digit;
+      }
+    }
+    end = std::copy(u.name.begin(), u.name.end(), end);
+    const size_t length = static_cast<size_t>(end - text);
+    if (best_length == 0 || length < best_length) {
+      std::copy(text, end, best);
+      best_length = length;
+    }
+  }
+  char plain[32];
+  char *end = std::to_chars(plain, plain + 20, bytes).ptr;
+  *end++ = 'B';
+  if (best_length == 0 || static_cast<size_t>(end - plain) < best_length) {
+    out << std::string_view(plain, static_cast<size_t>(end - plain));
+    return;
+  }
+  out << std::string_view(best, best_length);
+}
+
+/* a duration unit and its length in ticks of a period P, largest first;
+ * den is not 1 for units shorter than a tick */
+struct DurationUnit {
+  std::string_view name;
+  std::uint64_t num;
+  std::uint64_t den;
+};
+
+template <typename Unit, typename P>
+constexpr DurationUnit duration_unit(std::string_view name) {
+  using R = std::ratio_divide<Unit, P>;
+  return {name, static_cast<std::uint64_t>(R::num),
+          static_cast<std::uint64_t>(R::den)};
+}
+
+// the first seven are the ones help writes
+template <typename P>
+inline constexpr DurationUnit duration_units[] = {
+    duration_unit<std::ratio<86400>, P>("d"),
+    duration_unit<std::ratio<3600>, P>("h"),
+    duration_unit<std::ratio<60>, P>("m"),
+    duration_unit<std::ratio<1>, P>("s"),
+    duration_unit<std::milli, P>("ms"),
+    duration_unit<std::micro, P>("us"),
+    duration_unit<std::nano, P>("ns"),
+    duration_unit<std::ratio<60>, P>("min"),
+    duration_unit<std::micro, P>("\xC2\xB5s")};
+
+/*
+ * 250ms, 1.5s, 1h30m: one or more numbers, whole or decimal, each with a
+ * unit of ns, us (or µs), ms, s, m (or min), h or d. A bare 0 needs no
+ * unit. The total must be a whole number of D's ticks unless D counts in
+ * floating point; only signed D take a leading '-'.
+ */
+template <typename D>
+std::optional<D> parse_duration(std::string_view text, Error &error) {
+  using Rep = typename D::rep;
+  using P = typename D::period;
+  static_assert(!std::ratio_less_v<P, std::nano>,
+                "durations finer than nanoseconds are not supported");
+  const auto &units = duration_units<P>;
+  auto fail = [&](size_t offset, std::string message) {
+    error.offset = offset;
+    error.message = std::move(message);
+    return std::nullopt;
+  };
+  if (text.empty()) {
+    return fail(0, "empty value");
+  }
+
+  const bool negative = std::is_signed_v<Rep> && text[0] == '-';
+  size_t pos = negative ? 1 : 0;
+  if (text.substr(pos) == "0") {
+    return D::zero();
+  }
+  if (pos == text.size()) {
+    return fail(pos, "expected a duration like 250ms or 1h30m");
+  }
+  std::uint64_t total{0};
+  long double total_float{0};
+  while (pos < text.size()) {
+    const size_t number_at = pos;
+    std::uint64_t mantissa;
+    unsigned scale;
+    const ConvertErrc scanned = scan_decimal(text, pos, mantissa, scale);
+    if (scanned != ConvertErrc::ok) {
+      return fail(number_at, scanned == ConvertErrc::invalid
+                                 ? "expected a duration like 250ms or 1h30m"
+                                 : "out of range for a duration");
+    }
+    const size_t unit_at = pos;
+    while (pos < text.size() && (text[pos] < '0' || text[pos] > '9') &&
+           text[pos] != '.') {
+      ++pos;
+    }
+    const std::string_view name = text.substr(unit_at, pos - unit_at);
+    const DurationUnit *unit = nullptr;
+    for (const DurationUnit &u : units) {
+      if (u.name == name) {
+        unit = &u;
+        break;
+      }
+    }
+    if (!unit) {
+      return fail(unit_at,
+                  (name.empty() ? std::string("missing unit")
+                                : "unknown unit '" + std::string(name) + "'") +
+                      ", expected ns, us, ms, s, m, h or d");
+    }
+    if constexpr (std::is_floating_point_v<Rep>) {
+      long double value = static_cast<long double>(mantissa);
+      for (unsigned i{0}; i < scale; ++i) {
+        value /= 10;
+      }
+      total_float += value * static_cast<long double>(unit->num) /
+                     static_cast<long double>(unit->den);
+    } else {
+      std::uint64_t ticks{0};
+      const ConvertErrc scaled =
+          scale_exact(mantissa, scale, unit->num, unit->den, ticks);
+      if (scaled == ConvertErrc::invalid) {
+        std::string_view tick = " tick";
+        for (const DurationUnit &u : units) {
+          if (u.num == 1 && u.den == 1) {
+            tick = u.name;
+            break;
+          }
+        }
+        return fail(number_at,
+                    "finer than the resolution of 1" + std::string(tick));
+      }
+      if (scaled != ConvertErrc::ok ||
+          ticks > std::numeric_limits<std::uint64_t>::max() - total) {
+        return fail(number_at, "out of range for a duration");
+      }
+      total += ticks;
+    }
+  }
+
+  if constexpr (std::is_floating_point_v<Rep>) {
+    return D(static_cast<Rep>(negative ? -total_float : total_float));
+  } else {
+    using U = std::make_unsigned_t<Rep>;
+    const std::uint64_t limit =
+        static_cast<U>(std::numeric_limits<Rep>::max()) + (negative ? 1 : 0);
+    if (total > limit) {
+      return fail(0, "out of range for a duration");
+    }
+    const U magnitude = static_cast<U>(total);
+    return D(static_cast<Rep>(negative ? U(0) - magnitude : magnitude));
+  }
+}
+
+/* 1h30m, 250ms, 0s: the largest units first */
+template <typename D> void write_duration(std::ostream &out, const D &value) {
+  using Rep = typename D::rep;
+  if constexpr (std::is_floating_point_v<Rep>) {
+    out << std::chrono::duration<double>(value).count() << 's';
+  } else {
+    using U = std::make_unsigned_t<Rep>;
+    U left = static_cast<U>(value.count());
+    if (value.count() < 0) {
+      out << '-';
+      left = U(0) - left;
+    }
+    if (left == 0) {
+      out << "0s";
+      return;
+    }
+    for (size_t i{0}; i < 7 && left > 0; ++i) {
+      const DurationUnit &u = duration_units<typename D::period>[i];
+      if (u.den == 1 && left >= u.num) {
+        out << +(left / u.num) << u.name;
+        left %= u.num;
+      }
+    }
+    if (left > 0) {
+      out << '+' << +left << "ticks";
+    }
+  }
+}
+
+/* digits of a CPU number from text[pos]; npos without any */
+inline size_t scan_cpu(std::string_view text, size_t &pos) {
+  size_t value{0};
+  const size_t start = pos;
+  for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+    value = std::min<size_t>(value * 10 + static_cast<size_t>(text[pos] - '0'),
+                             CpuSet::max_cpus);
+  }
+  return pos == start ? std::string_view::npos : value;
+}
+
+/* 0-3,8-11 or 0-15:2 (every second CPU), as taskset -c takes them */
+inline std::optional<CpuSet> parse_cpu_set(std::string_view text,
+                                           Error &error) {
+  auto fail = [&](size_t offset, std::string message) {
+    error.offset = offset;
+    error.message = std::move(message);
+    return std::nullopt;
+  };
+  if (text.empty()) {
+    return fail(0, "empty CPU list");
+  }
+  CpuSet set;
+  size_t pos{0};
+  for (;;) {
+    const size_t item = pos;
+    const size_t first = scan_cpu(text, pos);
+    if (first == std::string_view::npos) {
+      return fail(pos, "expected a CPU number");
+    }
+    size_t last = first;
+    size_t stride{1};
+    if (pos < text.size() && text[pos] == '-') {
+      last = scan_cpu(text, ++pos);
+      if (last == std::string_view::npos) {
+        return fail(pos, "expected a CPU number");
+      }
+      if (pos < text.size() && text[pos] == ':') {
+        stride = scan_cpu(text, ++pos);
+        if (stride == std::string_view::npos || stride == 0) {
+          return fail(pos, "expected a stride of 1 or more");
+        }
+      }
+      if (last < first) {
+        return fail(item, "CPU range " + std::to_string(first) + "-" +
+                              std::to_string(last) + " ends before it starts");
+      }
+    }
+    if (last >= CpuSet::max_cpus) {
+      return fail(item, "CPU number above " +
+                            std::to_string(CpuSet::max_cpus - 1));
+    }
+    for (size_t cpu{first}; cpu <= last; cpu += stride) {
+      set.set(cpu);
+    }
+    if (pos == text.size()) {
+      return set;
+    }
+    if (text[pos] != ',') {
+      return fail(pos, "unexpected '" + std::string(1, text[pos]) +
+                           "' in CPU list");
+    }
+    ++pos;
+  }
+}
+
+/* 0-3,8-11: runs of two or more as ranges */
+inline void write_cpu_set(std::ostream &out, const CpuSet &set) {
+  bool any{false};
+  for (size_t cpu{0}; cpu < CpuSet::max_cpus; ++cpu) {
+    if (!set.test(cpu)) {
+      continue;
+    }
+    size_t last = cpu;
+    while (last + 1 < CpuSet::max_cpus && set.test(last + 1)) {
+      ++last;
+    }
+    out << (any ? "," : "") << cpu;
+    if (last > cpu) {
+      out << '-' << last;
+    }
+    any = true;
+    cpu = last;
+  }
+}
+
+/* 9000-9010, -5--1 or a single 9000; each end is a number as
+ * parse_number() reads it, and the range must not run backwards */
+template <typename T>
+std::optional<Range<T>> parse_range(std::string_view text, Error &error) {
+  const size_t dash = text.empty() ? std::string_view::npos
+                                   : text.find('-', 1);
+  Range<T> range;
+  auto end = [&](std::string_view part, size_t at, T &out) {
+    NumberResult r = parse_number(part, out);
+    if (!r) {
+      error.offset = at + r.offset;
+      error.message = number_error<T>(part, r);
+    }
+    return static_cast<bool>(r);
+  };
+  if (dash == std::string_view::npos) {
+    if (!end(text, 0, range.first)) {
+      return std::nullopt;
+    }
+    range.last = range.first;
+    return range;
+  }
+  if (!end(text.substr(0, dash), 0, range.first) ||
+      !end(text.substr(dash + 1), dash + 1, range.last)) {
+    return std::nullopt;
+  }
+  if (range.last < range.first) {
+    error.offset = dash + 1;
+    error.message = "range ends before it starts";
+    return std::nullopt;
+  }
+  return range;
+}
+
+/* the built-in conversions, name is the option for error messages. On
+ * failure the reason is in error.message and error.offset points at the
+ * offending character. */
+template <typename V>
+std::optional<V> convert_value(std::string_view str, std::string_view name,
+                               Error &error) {
+  if constexpr (std::is_same_v<V, std::string>) {
+    return std::string(str);
+  } else if constexpr (std::is_same_v<V, bool>) {
+    bool value{false};
+    if (!boolify(str, value)) {
+      error.message = "Invalid boolean value: " + std::string(str);
+      return std::nullopt;
+    }
+    return value;
+  } else if constexpr (std::is_same_v<V, char>) {
+    if (str.size() != 1) {
+      error.message = "expected a single character";
+      return std::nullopt;
+    }
+    return str[0];
+  } else if constexpr (std::is_same_v<V, ByteSize>) {
+    return parse_byte_size(str, error);
+  } else if constexpr (IsDuration<V>::value) {
+    return parse_duration<V>(str, error);
+  } else if constexpr (std::is_same_v<V, CpuSet>) {
+    return parse_cpu_set(str, error);
+  } else if constexpr (IsRange<V>::value) {
+    return parse_range<typename V::value_type>(str, error);
+  } else if constexpr (std::is_arithmetic_v<V>) {
+    V value{};
+    NumberResult r = parse_number(str, value);
+    if (!r) {
+      error.offset = r.offset;
+      error.message = number_error<V>(str, r);
+      return std::nullopt;
+    }
+    return value;
+  } else {
+    // todo: add link to docs.
+    error.message = "No default converter for this type. "
+                    "Please provide a custom .converter() for --" +
+                    std::string(name);
+    return std::nullopt;
+  }
+}
+
+/* appends the delimited elements of value to list in one pass, with the
+ * capacity for all of them reserved up front. element(item, index) returns
+ * an empty optional to stop; error.offset is then moved to the whole
+ * value. */
+template <typename List, typename Element>
+bool split_list(List &list, std::string_view value, char delimiter,
+                Error &error, Element &&element) {
+  auto add = [&](std::string_view item, size_t index) {
+    auto converted = element(item, index);
+    if (!converted) {
+      error.offset += static_cast<size_t>(item.data() - value.data());
+      return false;
+    }
+    list.push_back(std::move(*converted));
+    return true;
+  };
+
+  if (delimiter == '\0') {
+    return add(value, 0);
+  }
+
+  list.reserve(list.size() + count_char(value, delimiter) + 1);
+  const char *p = value.data();
+  const char *end = p + value.size();
+  for (size_t index{0};; ++index) {
+    auto *d = static_cast<const char *>(
+        std::memchr(p, delimiter, static_cast<size_t>(end - p)));
+    std::string_view item(p, static_cast<size_t>((d ? d : end) - p));
+    if (!add(trim_spaces(item), index)) {
+      return false;
+    }
+    if (!d) {
+      return true;
+    }
+    p = d + 1;
+  }
+}
+
+inline void element_error(std::string_view item, size_t index, Error &error) {
+  error.message = "element " + std::to_string(index) + " '" +
+                  std::string(item) + "': " + error.message;
+}
+
+template <typename V>
+std::optional<V> convert_element(std::string_view item, size_t index,
+                                 std::string_view name, Error &error) {
+  std::optional<V> value = convert_value<V>(item, name, error);
+  if (!value) {
+    element_error(item, index, error);
+  }
+  return value;
+}
+} // namespace Detail
+
+/* as help shows defaults, and as they are parsed back */
+inline std::ostream &operator<<(std::ostream &out, ByteSize size) {
+  Detail::write_byte_size(out, size.bytes);
+  return out;
+}
+
+inline std::ostream &operator<<(std::ostream &out, const CpuSet &set) {
+  Detail::write_cpu_set(out, set);
+  return out;
+}
+
+template <typename T>
+std::ostream &operator<<(std::ostream &out, const Range<T> &range) {
+  out << +range.first;
+  if (range.last != range.first) {
+    out << '-' << +range.last;
+  }
+  return out;
+}
+
+/* registration tokens for `parser >> arg(...)`, consumed within the same
+ * expression, so the names are only viewed until the parser interns them */
+template <typename T> struct ArgP {
+  std::string_view name;
+  std::string_view short_name;
+  T *value_ptr;
+
+  ArgP(std::string_view n, std::string_view sn, T *p)
+      : name(n), short_name(sn), value_ptr(p) {}
+};
+
+struct FlagP {
+  std::string_view name;
+  std::string_view short_name;
+  bool *value_ptr;
+
+  FlagP(std::string_view n, std::string_view sn, bool *p)
+      : name(n), short_name(sn), value_ptr(p) {}
+};
+
+/*
+ * Bump allocator owning the registered schema: argument objects and their
+ * interned names and help text sit next to each other in a few large
+ * blocks instead of one heap node each. Memory is released with the arena.
+ */
+class Arena {
+public:
+  Arena() = default;
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  void *allocate(size_t size, size_t align) {
+    std::uintptr_t base = current_base_();
+    std::uintptr_t at = (base + used_in_block_ + align - 1) & ~(align - 1);
+    if (blocks_.empty() || at + size > base + block_size_) {
+      // blocks double up to 64 KiB, oversized requests get their own block
+      size_t next =
+          blocks_.empty() ? 4096 : std::min<size_t>(block_size_ * 2, 65536);
+      block_size_ = std::max(next, size + align);
+      blocks_.emplace_back(new unsigned char[block_size_]);
+      reserved_ += block_size_;
+      base = current_base_();
+      at = (base + align - 1) & ~(align - 1);
+    }
+    used_in_block_ = at + size - base;
+    used_ += size;
+    return reinterpret_cast<void *>(at);
+  }
+
+  template <typename T, typename... Args> T *create(Args &&...args) {
+    return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  /* copy text into the arena, the view stays valid as long as the arena */
+  std::string_view intern(std::string_view text) {
+    if (text.empty()) {
+      return {};
+    }
+    auto *p = static_cast<char *>(allocate(text.size(), 1));
+    std::copy(text.begin(), text.end(), p);
+    return {p, text.size()};
+  }
+
+  size_t used() const { return used_; }
+  size_t reserved() const { return reserved_; }
+
+private:
+  std::vector<std::unique_ptr<unsigned char[]>> blocks_;
+  size_t block_size_ = 0;
+  size_t used_in_block_ = 0;
+  size_t used_ = 0;
+  size_t reserved_ = 0;
+
+  std::uintptr_t current_base_() const {
+    return blocks_.empty()
+               ? 0
+               : reinterpret_cast<std::uintptr_t>(blocks_.back().get());
+  }
+};
+
+namespace Detail {
+/* Levenshtein distance of a and b, limit + 1 as soon as it is known to be
+ * larger than limit */
+inline size_t edit_distance(std::string_view a, std::string_view b,
+                            size_t limit) {
+  if (a.size() > b.size()) {
+    std::swap(a, b);
+  }
+  if (b.size() - a.size() > limit) {
+    return limit + 1;
+  }
+  // one row of the table, over the shorter string
+  std::array<size_t, 64> small;
+  std::vector<size_t> large;
+  size_t *row = small.data();
+  if (a.size() >= small.size()) {
+    large.resize(a.size() + 1);
+    row = large.data();
+  }
+  for (size_t i{0}; i <= a.size(); ++i) {
+    row[i] = i;
+  }
+  for (size_t j{1}; j <= b.size(); ++j) {
+    size_t diagonal = row[0];
+    row[0] = j;
+    size_t best = row[0];
+    for (size_t i{1}; i <= a.size(); ++i) {
+      const size_t above = row[i];
+      row[i] = std::min({above + 1, row[i - 1] + 1,
+                         diagonal + (a[i - 1] != b[j - 1])});
+      diagonal = above;
+      best = std::min(best, row[i]);
+    }
+    if (best > limit) {
+      return limit + 1;
+    }
+  }
+  return std::min(row[a.size()], limit + 1);
+}
+
+/* edit_distance() where swapping two adjacent characters is one edit, the
+ * most common typo (--thersold); at most limit + 1 like edit_distance() */
+inline size_t typo_distance(std::string_view a, std::string_view b,
+                            size_t limit) {
+  if (a.size() > b.size()) {
+    std::swap(a, b);
+  }
+  if (b.size() - a.size() > limit) {
+    return limit + 1;
+  }
+  // three rows: two back, the last one and the one being filled
+  const size_t n = a.size() + 1;
+  std::array<size_t, 3 * 64> small;
+  std::vector<size_t> large;
+  size_t *rows = small.data();
+  if (3 * n > small.size()) {
+    large.resize(3 * n);
+    rows = large.data();
+  }
+  size_t *before = rows;
+  size_t *last = rows + n;
+  size_t *row = rows + 2 * n;
+  for (size_t i{0}; i < n; ++i) {
+    last[i] = i;
+  }
+  for (size_t j{1}; j <= b.size(); ++j) {
+    row[0] = j;
+    size_t best = row[0];
+    for (size_t i{1}; i < n; ++i) {
+      row[i] = std::min({last[i] + 1, row[i - 1] + 1,
+                         last[i - 1] + (a[i - 1] != b[j - 1])});
+      if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1]) {
+        row[i] = std::min(row[i], before[i - 2] + 1);
+      }
+      best = std::min(best, row[i]);
+    }
+    if (best > limit) {
+      return limit + 1;
+    }
+    std::swap(before, last);
+    std::swap(last, row);
+  }
+  return std::min(last[a.size()], limit + 1);
+}
+
+/*
+ * edit_distance() from one pattern of up to 64 characters to many texts,
+ * bit-parallel (Myers, Hyyro): a column of the table is one machine word,
+ * so a text costs a few instructions per character
+ */
+class PatternDistance {
+public:
+  static constexpr size_t max_size = 64;
+
+  explicit PatternDistance(std::string_view pattern) : size_(pattern.size()) {
+    for (size_t i{0}; i < size_; ++i) {
+      masks_[static_cast<unsigned char>(pattern[i])] |= std::uint64_t{1}
+                                                        << i;
+    }
+  }
+
+  size_t operator()(std::string_view text, size_t limit) const {
+    const size_t longer = std::max(size_, text.size());
+    if (longer - std::min(size_, text.size()) > limit) {
+      return limit + 1;
+    }
+    if (size_ == 0) {
+      return std::min(text.size(), limit + 1);
+    }
+    const std::uint64_t last = std::uint64_t{1} << (size_ - 1);
+    std::uint64_t plus = ~std::uint64_t{0}; // vertical +1 deltas
+    std::uint64_t minus = 0;                // vertical -1 deltas
+    size_t score = size_;
+    for (size_t j{0}; j < text.size(); ++j) {
+      const std::uint64_t eq = masks_[static_cast<unsigned char>(text[j])];
+      const std::uint64_t xv = eq | minus;
+      const std::uint64_t xh = (((eq & plus) + plus) ^ plus) | eq;
+      std::uint64_t hplus = minus | ~(xh | plus);
+      std::uint64_t hminus = plus & xh;
+      if (hplus & last) {
+        ++score;
+      } else if (hminus & last) {
+        --score;
+      }
+      // the rest of the text can take off at most one per character
+      if (score > limit + (text.size() - j - 1)) {
+        return limit + 1;
+      }
+      hplus = (hplus << 1) | 1; // the first row counts up
+      hminus <<= 1;
+      plus = hminus | ~(xv | hplus);
+      minus = hplus & xv;
+    }
+    return std::min(score, limit + 1);
+  }
+
+private:
+  std::array<std::uint64_t, 256> masks_{};
+  size_t size_;
+};
+
+/*
+ * BK-tree of names: every child hangs off the edge of its distance to the
+ * parent, so a search within distance k only descends edges in
+ * [d - k, d + k] and looks at a small part of thousands of names.
+ */
+class NameTree {
+public:
+  void clear() {
+    text_.clear();
+    nodes_.clear();
+  }
+
+  void add(std::string_view name) {
+    const auto begin = static_cast<std::uint32_t>(text_.size());
+    text_.append(name);
+    const auto index = static_cast<std::uint32_t>(nodes_.size());
+    nodes_.push_back({begin, static_cast<std::uint32_t>(name.size()), none,
+                      none, 0, 0});
+    if (index == 0) {
+      return;
+    }
+    std::optional<PatternDistance> fast;
+    if (name.size() <= PatternDistance::max_size) {
+      fast.emplace(name);
+    }
+    std::uint32_t node{0};
+    for (;;) {
+      const std::string_view other = view_(node);
+      const size_t most = name.size() + other.size();
+      const auto edge = static_cast<std::uint32_t>(
+          fast ? (*fast)(other, most) : edit_distance(name, other, most));
+      if (edge == 0) {
+        nodes_.pop_back(); // a duplicate
+        text_.resize(begin);
+        return;
+      }
+      nodes_[node].reach = std::max(nodes_[node].reach, edge);
+      std::uint32_t child = nodes_[node].child;
+      while (child != none && nodes_[child].edge != edge) {
+        child = nodes_[child].sibling;
+      }
+      if (child == none) {
+        nodes_[index].edge = edge;
+        nodes_[index].sibling = nodes_[node].child;
+        nodes_[node].child = index;
+        return;
+      }
+      node = child;
+    }
+  }
+
+  /* f(name, distance) for every name within limit of query */
+  template <typename F>
+  void near(std::string_view query, size_t limit, F &&f) const {
+    if (nodes_.empty()) {
+      return;
+    }
+    std::optional<PatternDistance> fast;
+    if (query.size() <= PatternDistance::max_size) {
+      fast.emplace(query);
+    }
+    std::vector<std::uint32_t> pending{0};
+    while (!pending.empty()) {
+      const Node &node = nodes_[pending.back()];
+      const std::string_view name = view_(pending.back());
+      pending.pop_back();
+      // no child is worth a look past this bound
+      const size_t bound = limit + node.reach;
+      const size_t d =
+          fast ? (*fast)(name, bound) : edit_distance(query, name, bound);
+      if (d <= limit) {
+        f(name, d);
+      }
+      for (std::uint32_t child = node.child; child != none;
+           child = nodes_[child].sibling) {
+        const size_t edge = nodes_[child].edge;
+        if (edge + limit >= d && edge <= d + limit) {
+          pending.push_back(child);
+        }
+      }
+    }
+  }
+
+  size_t memory_usage() const {
+    return text_.capacity() + nodes_.capacity() * sizeof(Node);
+  }
+
+private:
+  static constexpr std::uint32_t none = 0xffffffffu;
+
+  struct Node {
+    std::uint32_t begin; // in text_
+    std::uint32_t size;
+    std::uint32_t child; // first child, the rest are its siblings
+    std::uint32_t sibling;
+    std::uint32_t edge;  // distance to the parent
+    std::uint32_t reach; // largest edge to a child
+  };
+
+  std::string text_;
+  std::vector<Node> nodes_;
+
+  std::string_view view_(std::uint32_t node) const {
+    return std::string_view(text_.data() + nodes_[node].begin,
+                            nodes_[node].size);
+  }
+};
+
+/*
+ * The closest few names to an unknown one by typo_distance(). The distance
+ * allowed grows with the length of the unknown name: none for one or two
+ * characters, one up to five, then two.
+ */
+class NearMatches {
+public:
+  static constexpr size_t max_matches = 3;
+
+  explicit NearMatches(std::string_view unknown)
+      : unknown_(unknown),
+        limit_(unknown.size() <= 2 ? 0 : unknown.size() <= 5 ? 1 : 2) {}
+
+  std::string_view unknown() const { return unknown_; }
+  size_t limit() const { return limit_; }
+
+  /* a name found within limit(), suggested as prefix + name */
+  void offer(std::string_view prefix, std::string_view name,
+             size_t distance) {
+    if (distance > limit_ || (matches_.size() == max_matches &&
+                              distance > matches_.back().distance)) {
+      return;
+    }
+    std::string spelled = std::string(prefix) + std::string(name);
+    for (const Match &match : matches_) {
+      if (match.spelled == spelled) {
+        return;
+      }
+    }
+    matches_.push_back({distance, std::move(spelled)});
+    std::sort(matches_.begin(), matches_.end(),
+              [](const Match &a, const Match &b) {
+                return a.distance != b.distance ? a.distance < b.distance
+                                                : a.spelled < b.spelled;
+              });
+    if (matches_.size() > max_matches) {
+      matches_.pop_back();
+    }
+  }
+
+  /* the distance is worked out here */
+  void offer(std::string_view prefix, std::string_view name) {
+    offer(prefix, name, typo_distance(unknown_, name, limit_));
+  }
+
+  /* candidates from a NameTree: a swap is two plain edits, so the tree is
+   * searched one edit wider and the candidates measured again */
+  void search(const NameTree &tree, std::string_view prefix) {
+    tree.near(unknown_, limit_ + 1,
+              [&](std::string_view name, size_t) { offer(prefix, name); });
+  }
+
+  /* the matches into error.suggestions and the end of its message */
+  void report(Error &error) const {
+    if (matches_.empty()) {
+      return;
+    }
+    error.message += " (did you mean ";
+    for (size_t i{0}; i < matches_.size(); ++i) {
+      if (i > 0) {
+        error.message += i + 1 == matches_.size() ? " or " : ", ";
+      }
+      error.message += matches_[i].spelled;
+      error.suggestions.push_back(matches_[i].spelled);
+    }
+    error.message += "?)";
+  }
+
+private:
+  struct Match {
+    size_t distance;
+    std::string spelled;
+  };
+
+  std::string_view unknown_;
+  size_t limit_;
+  std::vector<Match> matches_;
+};
+
+/* insert-only open addressing table of argument slots, keyed by a name that
+ * key_of(slot) returns. Used for duplicate checks while registering. */
+class SlotTable {
+public:
+  template <typename KeyOf>
+  std::uint32_t find(std::string_view name, KeyOf &&key_of) const {
+    if (table_.empty()) {
+      return npos;
+    }
+    const size_t mask = table_.size() - 1;
+    for (size_t pos = hash_name(name) & mask;; pos = (pos + 1) & mask) {
+      std::uint32_t entry = table_[pos];
+      if (entry == 0) {
+        return npos;
+      }
+      if (key_of(entry - 1) == name) {
+        return entry - 1;
+      }
+    }
+  }
+
+  template <typename KeyOf>
+  void insert(std::uint32_t slot, std::string_view name, KeyOf &&key_of) {
+    if ((size_ + 1) * 2 > table_.size()) {
+      std::vector<std::uint32_t> old = std::move(table_);
+      table_.assign(std::max<size_t>(16, old.size() * 2), 0);
+      for (std::uint32_t entry : old) {
+        if (entry != 0) {
+          place_(entry, key_of(entry - 1));
+        }
+      }
+    }
+    place_(slot + 1, name);
+    ++size_;
+  }
+
+  void clear() {
+    table_.clear();
+    size_ = 0;
+  }
+
+  size_t memory_usage() const {
+    return table_.capacity() * sizeof(std::uint32_t);
+  }
+
+  static constexpr std::uint32_t npos = 0xffffffffu;
+
+private:
+  std::vector<std::uint32_t> table_; // slot + 1, 0 is empty
+  size_t size_ = 0;
+
+  void place_(std::uint32_t entry, std::string_view name) {
+    const size_t mask = table_.size() - 1;
+    size_t pos = hash_name(name) & mask;
+    while (table_[pos] != 0) {
+      pos = (pos + 1) & mask;
+    }
+    table_[pos] = entry;
+  }
+};
+} // namespace Detail
+
+namespace Detail {
+/* private writable mapping of a whole file; writes never reach the file,
+ * pages are only copied when written to */
+class MappedFile {
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept { swap_(other); }
+  MappedFile &operator=(MappedFile &&other) noexcept {
+    swap_(other);
+    return *this;
+  }
+  ~MappedFile() { release_(); }
+
+  /* false with the reason in message when the file cannot be read */
+  static bool open(const std::string &path, MappedFile &file,
+                   std::string &message) {
+    file.release_();
+#if INCANTI_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      message = "Cannot open '" + path + "': " + std::strerror(errno);
+      return false;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+      int err = errno;
+      ::close(fd);
+      message = "Cannot stat '" + path + "': " + std::strerror(err);
+      return false;
+    }
+    file.size_ = static_cast<size_t>(st.st_size);
+    if (file.size_ > 0) {
+      void *p = ::mmap(nullptr, file.size_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        int err = errno;
+        ::close(fd);
+        file.size_ = 0;
+        message = "Cannot map '" + path + "': " + std::strerror(err);
+        return false;
+      }
+      file.data_ = static_cast<char *>(p);
+#ifdef MADV_SEQUENTIAL
+      ::madvise(p, file.size_, MADV_SEQUENTIAL); // read once, front to back
+#endif
+    }
+    ::close(fd);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+      message = "Cannot open '" + path + "'";
+      return false;
+    }
+    file.size_ = static_cast<size_t>(in.tellg());
+    file.buffer_.reset(new char[file.size_ + 1]);
+    in.seekg(0);
+    in.read(file.buffer_.get(), static_cast<std::streamsize>(file.size_));
+    file.data_ = file.buffer_.get();
+#endif
+    return true;
+  }
+
+  char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  char *data_ = nullptr;
+  size_t size_ = 0;
+#if !INCANTI_HAS_MMAP
+  std::unique_ptr<char[]> buffer_;
+#endif
+
+  void swap_(MappedFile &other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+#if !INCANTI_HAS_MMAP
+    std::swap(buffer_, other.buffer_);
+#endif
+  }
+
+  void release_() {
+#if INCANTI_HAS_MMAP
+    if (data_) {
+      ::munmap(data_, size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+};
+} // namespace Detail
+
+/*
+ * Command line tokens: argv, with `@file` arguments replaced by the
+ * contents of that response file. Files are memory-mapped and tokenized
+ * lazily in place: tokens are separated by whitespace or NUL, '...' and
+ * "..." group, and a backslash escapes the next character (not inside
+ * '...'). Plain tokens are views into the mapping; quoted or escaped ones
+ * are unescaped over their own bytes.
+ */
+class TokenStream {
+public:
+  /* files == nullptr disables response files */
+  TokenStream(int argc, char **argv, std::vector<Detail::MappedFile> *files,
+              size_t max_depth)
+      : argv_(argv), argc_(argc), files_(files), max_depth_(max_depth) {}
+
+  /* tokens of a command line held in [begin, end), split and unescaped in
+   * place like a shell would */
+  TokenStream(char *begin, char *end, std::vector<Detail::MappedFile> *files,
+              size_t max_depth)
+      : argv_(nullptr), argc_(0), files_(files), max_depth_(max_depth),
+        base_{begin, end, {}}, has_base_(true) {}
+
+  /* false at the end or on an error, see failed() */
+  bool next(std::string_view &token) {
+    if (peeked_) {
+      peeked_ = false;
+      token = peek_token_;
+      index_of_last_ = peek_index_;
+      return peek_valid_;
+    }
+    for (;;) {
+      if (!raw_next_(token)) {
+        return false;
+      }
+      if (files_ && token.size() > 1 && token[0] == '@') {
+        if (!open_(token.substr(1))) {
+          return false;
+        }
+        continue;
+      }
+      index_of_last_ = count_;
+      Detail::count_token();
+      return true;
+    }
+  }
+
+  bool peek(std::string_view &token) {
+    if (!peeked_) {
+      const int last = index_of_last_;
+      peek_valid_ = next(peek_token_);
+      peek_index_ = index_of_last_;
+      index_of_last_ = last;
+      peeked_ = true;
+    }
+    token = peek_token_;
+    return peek_valid_;
+  }
+
+  /* position of the last token from next(), counted like argv */
+  int index() const { return index_of_last_; }
+
+  bool failed() const { return error_.code != ErrorCode::none; }
+  Error &error() { return error_; }
+
+private:
+  struct Frame {
+    char *cur;
+    char *end;
+    std::string path;
+  };
+
+  char **argv_;
+  int argc_;
+  int index_{1};
+  std::vector<Detail::MappedFile> *files_;
+  size_t max_depth_;
+  std::vector<Frame> frames_; // response files
+  Frame base_{};
+  bool has_base_{false};
+  std::string_view peek_token_;
+  bool peeked_{false};
+  bool peek_valid_{false};
+  int count_{0}; // raw tokens read, @file arguments included
+  int index_of_last_{0};
+  int peek_index_{0};
+  Error error_;
+
+  bool raw_next_(std::string_view &token) {
+    while (!frames_.empty()) {
+      if (scan_(frames_.back(), token)) {
+        ++count_;
+        return true;
+      }
+      if (failed()) {
+        return false;
+      }
+      frames_.pop_back();
+    }
+    if (has_base_) {
+      if (scan_(base_, token)) {
+        ++count_;
+        return true;
+      }
+      if (failed()) {
+        return false;
+      }
+      has_base_ = false;
+    }
+    if (index_ < argc_) {
+      token = argv_[index_++];
+      ++count_;
+      return true;
+    }
+    return false;
+  }
+
+  bool fail_(ErrorCode code, std::string message) {
+    error_.code = code;
+    error_.argv_index = count_;
+    error_.message = std::move(message);
+    return false;
+  }
+
+  bool open_(std::string_view path) {
+    if (frames_.size() >= max_depth_) {
+      return fail_(ErrorCode::file_error,
+                   "Response files nested deeper than " +
+                       std::to_string(max_depth_) + " levels at @" +
+                       std::string(path));
+    }
+    std::string file_path(path);
+    files_->emplace_back();
+    std::string message;
+    if (!Detail::MappedFile::open(file_path, files_->back(), message)) {
+      files_->pop_back();
+      return fail_(ErrorCode::file_error, std::move(message));
+    }
+    char *data = files_->back().data();
+    frames_.push_back({data, data + files_->back().size(), file_path});
+    return true;
+  }
+
+  static bool is_space_(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' ||
+           c == '\f' || c == '\0';
+  }
+
+  /* false at the end of the frame or on an unterminated quote */
+  bool scan_(Frame &frame, std::string_view &token) {
+    char *cur = frame.cur;
+    char *end = frame.end;
+    for (; cur < end; ++cur) {
+      if (*cur == '\\' && cur + 1 < end && cur[1] == '\n') {
+        ++cur; // line continuation between tokens
+      } else if (!is_space_(*cur)) {
+        break;
+      }
+    }
+    if (cur == end) {
+      frame.cur = cur;
+      return false;
+    }
+
+    char *start = cur;
+    char *out = cur; // unescaped bytes are written behind the read cursor
+    char quote{0};
+    for (; cur < end; ++cur) {
+      char c = *cur;
+      if (quote) {
+        if (c == quote) {
+          quote = 0;
+          continue;
+        }
+        // inside "..." only \" \\ \$ \` and a line break are escapes
+        if (c == '\\' && quote == '"' && cur + 1 < end) {
+          char n = cur[1];
+          if (n == '\n') {
+            ++cur;
+            continue;
+          }
+          if (n == '"' || n == '\\' || n == '$' || n == '`') {
+            c = *++cur;
+          }
+        }
+      } else {
+        if (is_space_(c)) {
+          break;
+        }
+        if (c == '"' || c == '\'') {
+          quote = c;
+          continue;
+        }
+        if (c == '\\' && cur + 1 < end) {
+          c = *++cur;
+          if (c == '\n') {
+            continue; // line continuation
+          }
+        }
+      }
+      if (out != cur) {
+        *out = c;
+      }
+      ++out;
+    }
+    if (quote) {
+      // reported at the token being read, not the one before it
+      ++count_;
+      return fail_(ErrorCode::unterminated_quote,
+                   frame.path.empty()
+                       ? std::string("Unterminated quote in command line")
+                       : "Unterminated quote in response file '" +
+                             frame.path + "'");
+    }
+
+    frame.cur = cur;
+    token = std::string_view(start, static_cast<size_t>(out - start));
+    return true;
+  }
+};
+
+namespace Detail {
+constexpr std::uint32_t no_slot = std::numeric_limits<std::uint32_t>::max();
+
+/*
+ * The command line grammar, shared by every front end. Target maps names
+ * to slots (no_slot when unknown) and receives the values:
+ *   find_long(name), find_short(name), short_prefix(token, length),
+ *   find_char(c), is_flag(slot), name(slot), apply(slot, value, at,
+ *   error) (at: the Origin of value), positional(token, error), help(),
+ *   suggest(near) (offers its option names)
+ * apply() and positional() return false to stop; apply() fills in the
+ * code and message, the position in argv is added here. A positional()
+ * that leaves the code at none has rejected the token.
+ */
+template <typename Target>
+bool scan_tokens(TokenStream &tokens, Target &t, Error &error) {
+  auto fail = [&](ErrorCode code, int index, size_t offset,
+                  std::string option, std::string message) {
+    error.code = code;
+    error.argv_index = index;
+    error.offset = offset;
+    error.option = std::move(option);
+    error.message = std::move(message);
+    return false;
+  };
+  // the value came from token `index`, starting `offset` bytes in
+  auto apply = [&](std::uint32_t slot, std::string_view value, int index,
+                   size_t offset) {
+    if (t.apply(slot, value, {Source::command_line, index, offset}, error)) {
+      return true;
+    }
+    error.argv_index = index;
+    error.offset += offset;
+    return false;
+  };
+  auto missing = [&](int index, size_t offset, std::uint32_t slot,
+                     std::string shown) {
+    if (tokens.failed()) {
+      error = tokens.error();
+      return false;
+    }
+    return fail(ErrorCode::missing_value, index, offset,
+                std::string(t.name(slot)),
+                "Argument " + shown + " requires a value");
+  };
+
+  std::string_view arg;
+  while (tokens.next(arg)) {
+    const int index = tokens.index();
+    if (arg == "-h" || arg == "--help") {
+      t.help();
+      continue;
+    }
+
+    /* long options, starting with '--' */
+    if (arg.size() >= 2 && arg[0] == '-' && arg[1] == '-') {
+      std::string_view name = arg.substr(2);
+      std::string_view value;
+
+      // also support : "./prog --index=a1"
+      size_t eq = name.find('=');
+      if (eq != std::string_view::npos) {
+        value = name.substr(eq + 1);
+        name = name.substr(0, eq);
+      }
+
+      std::uint32_t slot = t.find_long(name);
+      if (slot == no_slot) {
+        fail(ErrorCode::unknown_option, index, 2, std::string(name),
+             "Unknown Argument: --" + std::string(name));
+        NearMatches near(name);
+        t.suggest(near);
+        near.report(error);
+        return false;
+      }
+
+      if (t.is_flag(slot)) {
+        if (!apply(slot, {}, index, 0)) {
+          return false;
+        }
+      } else if (!value.empty()) {
+        if (!apply(slot, value, index, 2 + eq + 1)) {
+          return false;
+        }
+      } else {
+        if (!tokens.next(value)) {
+          return missing(index, arg.size(), slot,
+                         "--" + std::string(name));
+        }
+        if (!apply(slot, value, tokens.index(), 0)) {
+          return false;
+        }
+      }
+    } else if (arg.size() > 1 && arg[0] == '-' && arg[1] != '-') {
+      /* short options, starting with '-' */
+      std::string_view short_name = arg.substr(1);
+
+      std::uint32_t exact = t.find_short(short_name);
+      if (exact != no_slot) {
+        if (t.is_flag(exact)) {
+          if (!apply(exact, {}, index, 0)) {
+            return false;
+          }
+        } else {
+          std::string_view value;
+          if (!tokens.peek(value) || value.empty() || value[0] == '-') {
+            return missing(index, arg.size(), exact,
+                           "-" + std::string(short_name));
+          }
+          tokens.next(value);
+          if (!apply(exact, value, tokens.index(), 0)) {
+            return false;
+          }
+        }
+        continue;
+      }
+
+      /* we try to find the longest registered multi-char short option
+       that matches beginning of what the user provided: -th8 */
+      size_t prefix_length{0};
+      std::uint32_t prefix = t.short_prefix(short_name, prefix_length);
+      if (prefix != no_slot) {
+        std::string_view value_part = short_name.substr(prefix_length);
+        if (t.is_flag(prefix)) {
+          return fail(ErrorCode::unexpected_value, index, 1 + prefix_length,
+                      std::string(t.name(prefix)),
+                      "Flag -" +
+                          std::string(short_name.substr(0, prefix_length)) +
+                          " doesn't accept a value, but got: " +
+                          std::string(value_part));
+        }
+        if (!apply(prefix, value_part, index, 1 + prefix_length)) {
+          return false;
+        }
+        continue;
+      }
+
+      /* single char parsing | combining of different flags like : '-vdi',
+       the first option taking a value gets the rest: '-vdt4' */
+      for (size_t j{0}; j < short_name.length(); ++j) {
+        std::uint32_t slot = t.find_char(short_name[j]);
+        if (slot == no_slot) {
+          fail(ErrorCode::unknown_option, index, 1 + j,
+               std::string(short_name.substr(j, 1)),
+               "Unknown argument: -" + std::string(short_name.substr(j, 1)));
+          // the whole word may be a long option with one dash: -verbose
+          NearMatches near(short_name);
+          t.suggest(near);
+          near.report(error);
+          return false;
+        }
+
+        if (t.is_flag(slot)) {
+          if (!apply(slot, {}, index, 0)) {
+            return false;
+          }
+        } else {
+          if (j < short_name.length() - 1) {
+            // value is attached to single char: -ofile.txt | -vfd
+            if (!apply(slot, short_name.substr(j + 1), index, 1 + j + 1)) {
+              return false;
+            }
+            break;
+          } else {
+            std::string_view value;
+            if (!tokens.next(value)) {
+              return missing(index, arg.size(), slot,
+                             "-" + std::string(short_name.substr(j, 1)));
+            }
+            if (!apply(slot, value, tokens.index(), 0)) {
+              return false;
+            }
+          }
+        }
+      }
+    } else if (!t.positional(arg, error)) {
+      if (error.code != ErrorCode::none) {
+        error.argv_index = index;
+        return false;
+      }
+      return fail(ErrorCode::unexpected_positional, index, 0, {},
+                  "Unexpected positional argument: " + std::string(arg));
+    }
+  }
+  if (tokens.failed()) {
+    error = tokens.error();
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Single pass over a `key = value` config file (an INI / TOML subset) held
+ * in writable memory, no tree is built:
+ *
+ *   # comment            ; comment
+ *   threads = 8          bare value, a trailing # comment is dropped
+ *   name = "a \"b\""     basic string, escapes are undone in place
+ *   path = 'C:\dir'      literal string
+ *   ports = [80, "443"]  array, one call per element, may span lines
+ *   [server]             later keys are read as server-<key>
+ *
+ * on_entry(const ConfigEntry &) gets views into the buffer (the key of a
+ * sectioned entry is in a reused scratch string) and returns false to stop;
+ * syntax errors are reported as config_syntax.
+ */
+struct ConfigEntry {
+  std::string_view key;
+  std::string_view value;
+  size_t line;
+  size_t key_column; // 1-based
+  size_t column;     // of the value
+  bool element;      // one element of an array
+};
+
+/* the list options one config file has set so far; the first entry of
+ * a list in a later file replaces what the earlier files gave it */
+struct ConfigLists {
+  std::vector<std::uint32_t> seen;
+
+  bool first(std::uint32_t slot) {
+    if (std::find(seen.begin(), seen.end(), slot) != seen.end()) {
+      return false;
+    }
+    seen.push_back(slot);
+    return true;
+  }
+};
+
+inline constexpr std::array<bool, 256> config_key_chars = [] {
+  std::array<bool, 256> table{};
+  for (int c = 0; c < 256; ++c) {
+    table[c] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.';
+  }
+  return table;
+}();
+
+template <typename OnEntry>
+bool scan_config(char *data, size_t size, std::string_view path,
+                 Error &error, OnEntry &&on_entry) {
+  char *p = data;
+  char *end = data + size;
+  char *line_start = data;
+  size_t line{1};
+  std::string section;
+  std::string scratch;
+
+  auto fail = [&](const char *at, const std::string &message) {
+    error.code = ErrorCode::config_syntax;
+    error.message = std::string(path) + ":" + std::to_string(line) + ":" +
+                    std::to_string(at - line_start + 1) + ": " + message;
+    return false;
+  };
+  auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+  auto key_char = [](char c) {
+    return config_key_chars[static_cast<unsigned char>(c)];
+  };
+  auto trimmed = [&](const char *start) {
+    const char *last = p;
+    while (last > start && blank(last[-1])) {
+      --last;
+    }
+    return std::string_view(start, static_cast<size_t>(last - start));
+  };
+  auto skip_blank = [&] {
+    while (p < end && blank(*p)) {
+      ++p;
+    }
+  };
+  auto new_line = [&] {
+    ++p;
+    ++line;
+    line_start = p;
+  };
+  auto skip_comment = [&] {
+    auto *eol = static_cast<char *>(
+        std::memchr(p, '\n', static_cast<size_t>(end - p)));
+    p = eol ? eol : end;
+  };
+  // rest of the line must be empty or a comment
+  auto finish_line = [&](const char *what) {
+    skip_blank();
+    if (p < end && *p == '#') {
+      skip_comment();
+    }
+    if (p < end && *p != '\n') {
+      return fail(p, std::string("unexpected characters after ") + what);
+    }
+    if (p < end) {
+      new_line();
+    }
+    return true;
+  };
+  // quoted strings, unescaped into the bytes they were read from
+  auto quoted = [&](std::string_view &value) {
+    const char quote = *p;
+    const char *open = p;
+    char *out = ++p;
+    char *start = p;
+    for (; p < end && *p != quote && *p != '\n'; ++p) {
+      char c = *p;
+      if (c == '\\' && quote == '"' && p + 1 < end) {
+        switch (*++p) {
+        case 'n':
+          c = '\n';
+          break;
+        case 't':
+          c = '\t';
+          break;
+        case 'r':
+          c = '\r';
+          break;
+        case '"':
+        case '\\':
+          c = *p;
+          break;
+        default:
+          return fail(p - 1, "unknown escape sequence");
+        }
+      }
+      *out++ = c;
+    }
+    if (p == end || *p != quote) {
+      return fail(open, "unterminated string");
+    }
+    ++p;
+    value = std::string_view(start, static_cast<size_t>(out - start));
+    return true;
+  };
+
+  while (p < end) {
+    skip_blank();
+    if (p == end) {
+      break;
+    }
+    if (*p == '\n') {
+      new_line();
+      continue;
+    }
+    if (*p == '#' || *p == ';') {
+      skip_comment();
+      continue;
+    }
+
+    if (*p == '[') {
+      ++p;
+      skip_blank();
+      const char *start = p;
+      while (p < end && key_char(*p)) {
+        ++p;
+      }
+      if (p == start) {
+        return fail(start, "expected a section name");
+      }
+      section.assign(start, static_cast<size_t>(p - start));
+      skip_blank();
+      if (p == end || *p != ']') {
+        return fail(p, "expected ']' after section name");
+      }
+      ++p;
+      if (!finish_line("section header")) {
+        return false;
+      }
+      continue;
+    }
+
+    const char *key_start = p;
+    const size_t key_column = static_cast<size_t>(p - line_start + 1);
+    while (p < end && key_char(*p)) {
+      ++p;
+    }
+    if (p == key_start) {
+      return fail(p, "expected a key");
+    }
+    std::string_view key(key_start, static_cast<size_t>(p - key_start));
+    if (!section.empty()) {
+      scratch.assign(section).append(1, '-').append(key);
+      key = scratch;
+    }
+    skip_blank();
+    if (p == end || *p != '=') {
+      return fail(p, "expected '=' after key '" + std::string(key) + "'");
+    }
+    ++p;
+    skip_blank();
+    if (p == end || *p == '\n' || *p == '#') {
+      return fail(p, "expected a value for '" + std::string(key) + "'");
+    }
+
+    const size_t key_line = line;
+    const size_t column = static_cast<size_t>(p - line_start + 1);
+    std::string_view value;
+    if (*p == '"' || *p == '\'') {
+      if (!quoted(value)) {
+        return false;
+      }
+    } else if (*p == '[') {
+      const char *open = p;
+      ++p;
+      for (;;) {
+        // whitespace, newlines and comments between elements
+        for (;;) {
+          skip_blank();
+          if (p < end && *p == '\n') {
+            new_line();
+          } else if (p < end && *p == '#') {
+            skip_comment();
+          } else {
+            break;
+          }
+        }
+        if (p == end) {
+          line = key_line;
+          return fail(open, "unterminated array");
+        }
+        if (*p == ']') {
+          ++p;
+          break;
+        }
+        const size_t element_column = static_cast<size_t>(p - line_start + 1);
+        std::string_view element;
+        if (*p == '"' || *p == '\'') {
+          if (!quoted(element)) {
+            return false;
+          }
+        } else {
+          const char *start = p;
+          while (p < end && *p != ',' && *p != ']' && *p != '\n' &&
+                 *p != '#') {
+            ++p;
+          }
+          element = trimmed(start);
+        }
+        if (!on_entry(ConfigEntry{key, element, line, key_column,
+                                  element_column, true})) {
+          return false;
+        }
+        skip_blank();
+        if (p < end && *p == ',') {
+          ++p;
+        } else if (p < end && *p != ']' && *p != '\n' && *p != '#') {
+          return fail(p, "expected ',' or ']' in array");
+        }
+      }
+      if (!finish_line("array")) {
+        return false;
+      }
+      continue;
+    } else {
+      // the line ends at the newline or a '#' after a blank
+      const char *start = p;
+      auto *eol = static_cast<char *>(
+          std::memchr(p, '\n', static_cast<size_t>(end - p)));
+      eol = eol ? eol : end;
+      for (;;) {
+        auto *hash = static_cast<char *>(
+            std::memchr(p, '#', static_cast<size_t>(eol - p)));
+        if (!hash || blank(hash[-1])) {
+          p = hash ? hash : eol;
+          break;
+        }
+        p = hash + 1;
+      }
+      value = trimmed(start);
+    }
+    if (!on_entry(ConfigEntry{key, value, key_line, key_column, column,
+                              false}) ||
+        !finish_line("value")) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* the option column of a help entry: -s, --name <value> */
+inline void help_spec(std::string &out, std::string_view name,
+                      std::string_view short_name, std::string_view hint) {
+  if (!short_name.empty()) {
+    out.append("-").append(short_name).append(", ");
+  }
+  out.append("--").append(name).append(hint);
+}
+
+/* the text column: help (default: x) [env: NAME] [required]; every part
+ * after the help starts with a space */
+inline void help_text(std::string &out, std::string_view help,
+                      std::string_view default_text, std::string_view env,
+                      bool required) {
+  out.append(help);
+
+  if (!default_text.empty() && !required) {
+    out.append(" (default: ").append(default_text).append(")");
+  }
+
+  if (!env.empty()) {
+    out.append(" [env: ").append(env).append("]");
+  }
+
+  if (required) {
+    out += " [required]";
+  }
+}
+
+/* one entry of the options list:
+ *   -s, --name <value>
+ *      help (default: x) [env: NAME] [required] */
+inline std::string help_entry(std::string_view name,
+                              std::string_view short_name,
+                              std::string_view hint, std::string_view help,
+                              std::string_view default_text,
+                              std::string_view env, bool required) {
+  std::string result;
+  help_spec(result, name, short_name, hint);
+  if (!help.empty()) {
+    result.append("\n   ");
+  }
+  help_text(result, help, default_text, env, required);
+  return result;
+}
+
+/* columns of the terminal on stdout: $COLUMNS, then the tty, then 80 */
+inline size_t terminal_width() {
+  if (const char *columns = std::getenv("COLUMNS")) {
+    size_t width{0};
+    const char *end = columns + std::strlen(columns);
+    if (std::from_chars(columns, end, width).ptr == end && width > 0) {
+      return width;
+    }
+  }
+#if INCANTI_HAS_MMAP && defined(TIOCGWINSZ)
+  struct winsize size {};
+  if (::isatty(STDOUT_FILENO) &&
+      ::ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0) {
+    return size.ws_col;
+  }
+#endif
+  return 80;
+}
+
+/* text to stdout in one write(2) (a loop only for partial writes), after
+ * whatever std::cout and stdio still hold */
+inline void write_stdout(std::string_view text) {
+  std::cout.flush();
+  std::fflush(stdout);
+#if INCANTI_HAS_MMAP
+  while (!text.empty()) {
+    ssize_t n = ::write(STDOUT_FILENO, text.data(), text.size());
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return;
+    }
+    text.remove_prefix(static_cast<size_t>(n));
+  }
+#else
+  std::fwrite(text.data(), 1, text.size(), stdout);
+  std::fflush(stdout);
+#endif
+}
+
+/*
+ * Reads standard input in blocks and passes each entry ended by separator
+ * (or by the end of input) to on_entry(std::string_view), skipping empty
+ * ones. Views are valid during the call; buffer is reused, so memory stays
+ * one block unless a single entry is longer. false with error filled in
+ * when the input cannot be read.
+ */
+template <typename OnEntry>
+bool read_stdin_entries(char separator, std::vector<char> &buffer,
+                        OnEntry &&on_entry, Error &error) {
+  constexpr size_t block = 64 * 1024;
+  if (buffer.size() < block) {
+    buffer.resize(block);
+  }
+  size_t kept{0}; // an unfinished entry at the front of the buffer
+  for (;;) {
+    if (kept == buffer.size()) {
+      buffer.resize(buffer.size() * 2);
+    }
+    char *begin = buffer.data();
+#if INCANTI_HAS_MMAP
+    ssize_t n = ::read(STDIN_FILENO, begin + kept, buffer.size() - kept);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      error.code = ErrorCode::file_error;
+      error.message = "Cannot read positionals from standard input: " +
+                      std::string(std::strerror(errno));
+      return false;
+    }
+#else
+    size_t n = std::fread(begin + kept, 1, buffer.size() - kept, stdin);
+    if (n == 0 && std::ferror(stdin)) {
+      error.code = ErrorCode::file_error;
+      error.message = "Cannot read positionals from standard input";
+      return false;
+    }
+#endif
+    if (n == 0) {
+      break;
+    }
+    char *start = begin;
+    char *scan = begin + kept;
+    char *end = scan + n;
+    while (auto *sep = static_cast<char *>(std::memchr(
+               scan, separator, static_cast<size_t>(end - scan)))) {
+      if (sep > start) {
+        on_entry(std::string_view(start, static_cast<size_t>(sep - start)));
+      }
+      start = scan = sep + 1;
+    }
+    kept = static_cast<size_t>(end - start);
+    std::memmove(begin, start, kept);
+  }
+  if (kept > 0) {
+    on_entry(std::string_view(buffer.data(), kept));
+  }
+  return true;
+}
+
+/*
+ * The help screen as two aligned columns:
+ *
+ *   Usage: prog [options]
+ *   description
+ *
+ *   Options:
+ *     -t, --threads <value>  Worker threads (default: 4)
+ *     --a-much-longer-option <value>
+ *                            text of an option too wide for the column
+ *
+ * The text column starts after the widest option that fits in 2/5 of the
+ * width, wider ones put their text on the next line; text is word wrapped
+ * at width. Rows are collected first, then rendered into one string.
+ */
+class HelpLayout {
+public:
+  explicit HelpLayout(size_t width) : width_(std::max<size_t>(width, 40)) {}
+
+  void add(std::string_view spec, std::string_view text) {
+    while (!text.empty() && text.front() == ' ') {
+      text.remove_prefix(1); // no help, only the (default: ...) part
+    }
+    const size_t begin = buffer_.size();
+    buffer_.append(spec).append(text);
+    rows_.push_back({begin, spec.size(), text.size()});
+  }
+
+  /* rows added from here on go under `title:`, the first section is
+   * "Options" unless named */
+  void section(std::string_view title) {
+    sections_.push_back({title, rows_.size()});
+  }
+
+  /* usage follows the program name on the first line */
+  void render(std::string &out, std::string_view program,
+              std::string_view description,
+              std::string_view usage = " [options]") const {
+    const size_t indent{2};
+    const size_t gap{2};
+    const size_t limit = std::max<size_t>(width_ * 2 / 5, 16);
+    size_t column = indent + gap;
+    for (const Row &row : rows_) {
+      if (indent + row.spec + gap <= limit) {
+        column = std::max(column, indent + row.spec + gap);
+      }
+    }
+    const size_t room = std::max<size_t>(width_ - column, 20);
+
+    out.clear();
+    out.reserve(buffer_.size() + rows_.size() * (column + 8) + 64);
+    if (!program.empty()) {
+      out.append("Usage: ").append(program).append(usage).append("\n");
+    }
+    if (!description.empty()) {
+      out.append(description).append("\n");
+    }
+    size_t next{0};
+    for (size_t i{0}; i < rows_.size(); ++i) {
+      if (i == 0 && (sections_.empty() || sections_[0].first > 0)) {
+        out.append("\nOptions:\n");
+      }
+      for (; next < sections_.size() && sections_[next].first == i; ++next) {
+        out.append("\n").append(sections_[next].title).append(":\n");
+      }
+      const Row &row = rows_[i];
+      std::string_view spec(buffer_.data() + row.begin, row.spec);
+      std::string_view text(buffer_.data() + row.begin + row.spec, row.text);
+      out.append(indent, ' ').append(spec);
+      if (text.empty()) {
+        out += '\n';
+        continue;
+      }
+      if (indent + spec.size() + gap > column) {
+        out.append("\n").append(column, ' ');
+      } else {
+        out.append(column - indent - spec.size(), ' ');
+      }
+      wrap_(out, text, column, room);
+    }
+  }
+
+private:
+  struct Row {
+    size_t begin; // spec, then text in buffer_
+    size_t spec;
+    size_t text;
+  };
+
+  struct Section {
+    std::string_view title;
+    size_t first; // row
+  };
+
+  size_t width_;
+  std::string buffer_;
+  std::vector<Row> rows_;
+  std::vector<Section> sections_;
+
+  /* greedy word wrap; newlines in the text are kept, words longer than a
+   * line get a line of their own */
+  static void wrap_(std::string &out, std::string_view text, size_t column,
+                    size_t room) {
+    size_t used{0};
+    while (!text.empty()) {
+      if (text.front() == '\n') {
+        out.append("\n").append(column, ' ');
+        used = 0;
+        text.remove_prefix(1);
+        continue;
+      }
+      if (text.front() == ' ') {
+        text.remove_prefix(1);
+        continue;
+      }
+      size_t length = std::min(text.find_first_of(" \n"), text.size());
+      if (used > 0 && used + 1 + length > room) {
+        out.append("\n").append(column, ' ');
+        used = 0;
+      } else if (used > 0) {
+        out += ' ';
+        ++used;
+      }
+      out.append(text.substr(0, length));
+      used += length;
+      text.remove_prefix(length);
+    }
+    out += '\n';
+  }
+};
+} // namespace Detail
+
+/* type-erased converter, the callable lives in inline storage so that
+ * registering a lambda does not allocate. Callables return T, or an
+ * Expected<T> to reject a value without throwing. */
+template <typename T> class Converter {
+public:
+  static constexpr size_t capacity = 4 * sizeof(void *);
+
+  Converter() = default;
+  Converter(const Converter &) = delete;
+  Converter &operator=(const Converter &) = delete;
+  ~Converter() { reset(); }
+
+  template <typename Func> void emplace(Func &&func) {
+    using F = std::decay_t<Func>;
+    reset();
+    if constexpr (sizeof(F) <= capacity &&
+                  alignof(F) <= alignof(std::max_align_t)) {
+      new (storage_) F(std::forward<Func>(func));
+      invoke_ = [](void *s, std::string_view v, Error &error) {
+        return call_(*static_cast<F *>(s), v, error);
+      };
+      destroy_ = [](void *s) { static_cast<F *>(s)->~F(); };
+    } else {
+      // oversized callables are kept out of line
+      *reinterpret_cast<F **>(storage_) = new F(std::forward<Func>(func));
+      invoke_ = [](void *s, std::string_view v, Error &error) {
+        return call_(**static_cast<F **>(s), v, error);
+      };
+      destroy_ = [](void *s) { delete *static_cast<F **>(s); };
+    }
+  }
+
+  void reset() {
+    if (destroy_) {
+      destroy_(storage_);
+    }
+    invoke_ = nullptr;
+    destroy_ = nullptr;
+  }
+
+  explicit operator bool() const { return invoke_ != nullptr; }
+
+  /* empty with the reason in error.message when the value is rejected */
+  std::optional<T> operator()(std::string_view value, Error &error) const {
+    return invoke_(storage_, value, error);
+  }
+
+private:
+  // mutable: a shared Schema calls converters through const arguments
+  alignas(std::max_align_t) mutable unsigned char storage_[capacity];
+  std::optional<T> (*invoke_)(void *, std::string_view, Error &) = nullptr;
+  void (*destroy_)(void *) = nullptr;
+
+  template <typename F>
+  static std::optional<T> call_(F &f, std::string_view value, Error &error) {
+    using R = std::decay_t<std::invoke_result_t<F &, std::string_view>>;
+    if constexpr (std::is_same_v<R, Expected<T>>) {
+      Expected<T> result = f(value);
+      if (!result) {
+        error = std::move(result.error());
+        return std::nullopt;
+      }
+      return std::move(*result);
+    } else {
+#if INCANTI_EXCEPTIONS
+      try {
+        return T(f(value));
+      } catch (const std::exception &e) {
+        error.message = e.what();
+        return std::nullopt;
+      }
+#else
+      return T(f(value));
+#endif
+    }
+  }
+};
+
+enum class ArgKind : std::uint8_t { value, flag };
+
+namespace Detail {
+/* one address per type, compared instead of RTTI */
+template <typename T> struct TypeTag {
+  static constexpr char id{};
+};
+
+/* where a value was read: the argv token it is in (-1 outside the command
+ * line) and where in that token it starts */
+struct Origin {
+  Source source = Source::command_line;
+  int argv_index = -1;
+  size_t offset = 0;
+};
+} // namespace Detail
+
+class Argument;
+
+/*
+ * Per-type operations, one static table for every TypedArgument<T>. They
+ * work on a target T rather than the bound variable, so the same schema
+ * can convert into a ParseResult as well.
+ */
+struct ArgumentOps {
+  // convert value into *target; the first value of a parse replaces a list.
+  // false when the value is rejected, with error filled in
+  bool (*store)(const Argument &self, void *target, std::string_view value,
+                bool first, const Detail::Origin &at, Error &error);
+  void (*render_default)(const Argument &self, std::ostream &out);
+  void (*destroy)(Argument &self);
+  // assign the default (def(), or a value-initialized T), see reset()
+  void (*restart)(const Argument &self, void *target);
+  // value storage of a ParseResult
+  void (*construct)(const Argument &self, void *target);
+  void (*destroy_value)(void *target);
+  // Reloadable values only, null otherwise: publish a converted value into
+  // the bound variable, then call its change callback (see ConfigWatcher)
+  void (*publish)(const Argument &self, const void *staged);
+  void (*notify)(const Argument &self);
+  const void *type;
+  size_t size;
+  size_t align;
+};
+
+class Schema;
+class Parser;
+class ConfigWatcher;
+
+/*
+ * Common part of every argument. Dispatch goes through the kind tag and the
+ * ops table of the concrete type, so parsing needs neither virtual calls
+ * nor RTTI.
+ */
+class Argument {
+public:
+  Argument(const Argument &) = delete;
+  Argument &operator=(const Argument &) = delete;
+
+  /* converts into the bound variable */
+  void parse(std::string_view value, Source source = Source::command_line) {
+    written_ = true;
+    Error error;
+    if (!ops_->store(*this, value_, value, source_ <= Source::default_value,
+                     {source, -1, 0}, error)) {
+      Detail::raise(ParseError(std::move(error)));
+    }
+    source_ = source;
+  }
+  bool has_value() const { return source_ != Source::none; }
+  /* where the bound variable got its value in the last Parser::parse() */
+  Source source() const { return source_; }
+  Source initial_source() const {
+    return has_default_ ? Source::default_value : Source::none;
+  }
+  bool is_required() const { return required_; }
+  bool is_flag() const { return kind_ == ArgKind::flag; }
+  bool is_list() const { return list_; }
+  /* converted on first read, see Lazy */
+  bool is_lazy() const { return lazy_; }
+  /* replaced by a ConfigWatcher while the program runs, see Reloadable */
+  bool is_reloadable() const { return ops_->publish != nullptr; }
+  ArgKind kind() const { return kind_; }
+  std::string get_name() const { return std::string(name_); }
+  std::string_view name() const { return name_; }
+  std::string_view short_name() const { return short_name_; }
+  std::string_view env_name() const { return env_; }
+  size_t choice_count() const { return choice_count_; }
+  std::string_view choice(size_t i) const { return choices_[i]; }
+
+  template <typename T> bool holds() const {
+    return ops_->type == &Detail::TypeTag<T>::id;
+  }
+
+  std::string get_help() const {
+    std::ostringstream scratch;
+    return Detail::help_entry(name_, short_name_, hint_(), help_,
+                              default_text_(scratch), env_, required_);
+  }
+
+  /* runs the destructor of the concrete type, the memory is the arena's */
+  void destroy() { ops_->destroy(*this); }
+
+  void restart() {
+    // without def(), a variable no parse has written keeps its own value
+    if (has_default_ || written_) {
+      ops_->restart(*this, value_);
+    }
+    source_ = initial_source();
+  }
+
+  bool store(void *target, std::string_view value, bool first,
+             const Detail::Origin &at, Error &error) const {
+    return ops_->store(*this, target, value, first, at, error);
+  }
+  void restart(void *target) const { ops_->restart(*this, target); }
+  void construct(void *target) const { ops_->construct(*this, target); }
+  void destroy_value(void *target) const { ops_->destroy_value(target); }
+  void publish(const void *staged) const { ops_->publish(*this, staged); }
+  void notify() const { ops_->notify(*this); }
+  size_t value_size() const { return ops_->size; }
+  size_t value_align() const { return ops_->align; }
+
+protected:
+  Argument(const ArgumentOps *ops, ArgKind kind, Arena &arena,
+           std::string_view name, std::string_view short_name, void *value,
+           bool value_hint)
+      : ops_(ops), arena_(&arena), value_(value), name_(name),
+        short_name_(short_name), kind_(kind), value_hint_(value_hint) {}
+  ~Argument() = default;
+
+  void set_help_(std::string_view help_text) {
+    help_ = arena_->intern(help_text);
+  }
+
+  void set_env_(std::string_view env_name) {
+    env_ = arena_->intern(env_name);
+  }
+
+  void set_choices_(const std::string_view *values, size_t count) {
+    auto *copy = static_cast<std::string_view *>(
+        arena_->allocate(count * sizeof(std::string_view),
+                         alignof(std::string_view)));
+    for (size_t i{0}; i < count; ++i) {
+      new (copy + i) std::string_view(arena_->intern(values[i]));
+    }
+    choices_ = copy;
+    choice_count_ = static_cast<std::uint32_t>(count);
+  }
+
+  /* false with the reason in error.message when value is not a choice */
+  bool check_choice_(std::string_view value, Error &error) const {
+    for (std::uint32_t i{0}; i < choice_count_; ++i) {
+      if (choices_[i] == value) {
+        return true;
+      }
+    }
+    error.message = "expected one of ";
+    Detail::NearMatches near(value);
+    for (std::uint32_t i{0}; i < choice_count_; ++i) {
+      error.message.append(i ? ", " : "").append(choices_[i]);
+      near.offer({}, choices_[i]);
+    }
+    near.report(error);
+    return false;
+  }
+
+  void set_default_() {
+    has_default_ = true;
+    if (source_ == Source::none) {
+      source_ = Source::default_value;
+    }
+  }
+
+  std::string hint_() const {
+    std::string hint;
+    if (value_hint_) {
+      hint = " <value>";
+      if (choice_count_ > 0) {
+        hint = " <";
+        for (std::uint32_t i{0}; i < choice_count_; ++i) {
+          hint.append(i ? "|" : "").append(choices_[i]);
+        }
+        hint += '>';
+      }
+      if (list_) {
+        // repeatable, and splittable unless the delimiter is off
+        if (delimiter_) {
+          hint.append(1, delimiter_).append("...");
+        } else {
+          hint += "...";
+        }
+      }
+    }
+    return hint;
+  }
+
+  /* the default as help shows it, scratch is reused between arguments */
+  std::string default_text_(std::ostringstream &scratch) const {
+    if (!has_default_ || required_) {
+      return {};
+    }
+    scratch.str(std::string());
+    ops_->render_default(*this, scratch);
+    return scratch.str();
+  }
+
+  /* both columns of the help screen */
+  void help_columns_(std::string &spec, std::string &text,
+                     std::ostringstream &scratch) const {
+    spec.clear();
+    text.clear();
+    Detail::help_spec(spec, name_, short_name_, hint_());
+    Detail::help_text(text, help_, default_text_(scratch), env_, required_);
+  }
+
+  const ArgumentOps *ops_;
+  Arena *arena_;
+  void *value_; // the bound variable
+  // views into the parser's arena
+  std::string_view name_;
+  std::string_view short_name_;
+  std::string_view help_;
+  std::string_view env_;
+  const std::string_view *choices_ = nullptr; // in the arena
+  std::uint32_t choice_count_ = 0;
+  ArgKind kind_;
+  bool value_hint_;
+  bool list_ = false;
+  bool lazy_ = false;
+  char delimiter_ = ',';
+  bool required_ = false;
+  bool has_default_ = false;
+  bool written_ = false; // by a parse, since registration
+  // state of the bound variable, written by Parser only
+  Source source_ = Source::none;
+
+  friend class Schema;
+  friend class Parser;
+};
+
+/*
+ * An argument bound to a T. When T is a std::vector<E>, every occurrence
+ * appends (-I a -I b) and each value is split on the delimiter
+ * (--ids 1,2,3); converters then convert a single element. A Lazy<V> only
+ * records the text, a Reloadable<V> converts a V and publishes it; either
+ * way converters and choices() apply to a V.
+ */
+template <typename T> class TypedArgument : public Argument {
+public:
+  static constexpr bool is_lazy = Detail::LazyTraits<T>::is_lazy;
+  static constexpr bool is_reloadable =
+      Detail::ReloadableTraits<T>::is_reloadable;
+  using value_type = typename Detail::LazyTraits<
+      typename Detail::ReloadableTraits<T>::value_type>::value_type;
+  static constexpr bool is_list = Detail::ListTraits<value_type>::is_list;
+  using element_type = typename Detail::ListTraits<value_type>::element_type;
+
+  static_assert(!is_list || !is_lazy,
+                "Lazy does not take a std::vector, bind the list itself");
+  static_assert(!is_reloadable || !Detail::LazyTraits<
+                    typename Detail::ReloadableTraits<T>::value_type>::is_lazy,
+                "A Reloadable cannot be Lazy");
+
+  TypedArgument(Arena &arena, std::string_view name,
+                std::string_view short_name, T *value_ptr)
+      : Argument(&ops_, ArgKind::value, arena, name, short_name, value_ptr,
+                 !std::is_same_v<value_type, bool>) {
+    list_ = is_list;
+    lazy_ = is_lazy;
+  }
+
+  TypedArgument &help(std::string_view help_text) {
+    set_help_(help_text);
+    return *this;
+  }
+
+  TypedArgument &default_value(const T &value) {
+    default_val_ = value;
+    if (source_ <= Source::default_value) {
+      *value_ptr_() = value;
+    }
+    set_default_();
+    return *this;
+  }
+
+  TypedArgument &required() {
+    required_ = true;
+    return *this;
+  }
+
+  /* as operator|(converter): stored inline, no std::function */
+  template <typename Func,
+            typename = std::enable_if_t<
+                std::is_invocable_r_v<Expected<element_type>, Func,
+                                      std::string_view> ||
+                std::is_invocable_r_v<Expected<element_type>, Func,
+                                      const std::string &>>>
+  TypedArgument &converter(Func &&conv) {
+    set_converter_(std::forward<Func>(conv));
+    return *this;
+  }
+
+  TypedArgument &delimiter(char delim) {
+    static_assert(is_list, "Only std::vector arguments take a delimiter");
+    delimiter_ = delim;
+    return *this;
+  }
+
+  TypedArgument<T> &operator|(delimiter_wrapper delim) {
+    return delimiter(delim.value);
+  }
+
+  /* used when the option is not on the command line */
+  TypedArgument &env(std::string_view env_name) {
+    set_env_(env_name);
+    return *this;
+  }
+
+  TypedArgument<T> &operator|(env_wrapper var) { return env(var.name); }
+
+  /* callback(const V &) runs after a ConfigWatcher publishes a new value,
+   * on the thread that reloaded */
+  template <typename Callback> TypedArgument &on_change(Callback &&callback) {
+    static_assert(is_reloadable, "Only Reloadable arguments change later");
+    value_ptr_()->on_change(std::forward<Callback>(callback));
+    return *this;
+  }
+
+  template <typename F>
+  TypedArgument<T> &operator|(change_wrapper<F> callback) {
+    return on_change(std::move(callback.callback));
+  }
+
+  /* restrict the value (each element of a list) to these words, which
+   * shell completion then offers */
+  template <size_t N>
+  TypedArgument<T> &operator|(const choices_wrapper<N> &values) {
+    set_choices_(values.values.data(), N);
+    return *this;
+  }
+
+  TypedArgument<T> &operator|(const char *help_text) {
+    set_help_(help_text);
+    return *this;
+  }
+
+  TypedArgument<T> &operator|(const std::string &help_text) {
+    set_help_(help_text);
+    return *this;
+  }
+
+  TypedArgument<T> &operator|(required_t) {
+    required_ = true;
+    return *this;
+  }
+
+  template <typename U>
+  TypedArgument<T> &operator|(const default_wrapper<U> &def_val) {
+    static_assert(std::is_convertible_v<U, T>,
+                  "Default value must be convertible to argument type");
+    return default_value(static_cast<T>(def_val.value));
+  }
+
+  /* converters may take std::string_view (no copy) or const std::string &
+   * and return the value or an Expected of it */
+  template <typename Func,
+            typename = std::enable_if_t<
+                std::is_invocable_r_v<Expected<element_type>, Func,
+                                      std::string_view> ||
+                std::is_invocable_r_v<Expected<element_type>, Func,
+                                      const std::string &>>>
+  TypedArgument<T> &operator|(Func &&converter) {
+    set_converter_(std::forward<Func>(converter));
+    return *this;
+  }
+
+private:
+  // def(), or a value-initialized T; the bound variable is never read
+  T default_val_{};
+  // empty unless a custom converter was given
+  Converter<element_type> str_to_T_;
+
+  T *value_ptr_() const { return static_cast<T *>(value_); }
+
+  static bool store_(const Argument &self, void *target,
+                     std::string_view value, bool first,
+                     const Detail::Origin &at, Error &error) {
+    T &out = *static_cast<T *>(target);
+    if constexpr (is_lazy) {
+      // converted when read, see Lazy::get()
+      (void)first;
+      (void)error;
+      out.defer_(self, value, at, &resolve_);
+      return true;
+    } else if constexpr (is_reloadable) {
+      // converted aside and published in one store
+      (void)at;
+      const auto &arg = static_cast<const TypedArgument &>(self);
+      value_type next{};
+      bool stored;
+      if constexpr (is_list) {
+        if (!first) {
+          next = out.load();
+        }
+        stored = arg.store_list_(next, value, false, error);
+      } else {
+        stored = arg.convert_(value, next, error);
+      }
+      if (!stored) {
+        arg.value_error_(value, error);
+        return false;
+      }
+      out.store(std::move(next));
+      return true;
+    } else {
+      (void)at;
+      const auto &arg = static_cast<const TypedArgument &>(self);
+      bool stored;
+      if constexpr (is_list) {
+        stored = arg.store_list_(out, value, first, error);
+      } else {
+        stored = arg.convert_(value, out, error);
+      }
+      if (!stored) {
+        arg.value_error_(value, error);
+      }
+      return stored;
+    }
+  }
+
+  /* one value through choices(), the converter or the built-in conversion
+   * into a value_type or an optional of one; false when it is rejected,
+   * with the reason in error.message */
+  template <typename Out>
+  bool convert_(std::string_view value, Out &out, Error &error) const {
+    if (choice_count_ > 0 && !check_choice_(value, error)) {
+      return false;
+    }
+    if (str_to_T_) {
+      std::optional<value_type> converted = str_to_T_(value, error);
+      if (!converted) {
+        return false;
+      }
+      out = std::move(*converted);
+    } else if constexpr (std::is_same_v<Out, std::string>) {
+      // reuse the capacity of the target string
+      out.assign(value.data(), value.size());
+    } else {
+      std::optional<value_type> converted =
+          Detail::convert_value<value_type>(value, name_, error);
+      if (!converted) {
+        return false;
+      }
+      out = std::move(*converted);
+    }
+    return true;
+  }
+
+  void value_error_(std::string_view value, Error &error) const {
+    error.code = ErrorCode::invalid_value;
+    error.option = std::string(name_);
+    error.message = "Failed to parse '" + std::string(value) +
+                    "' for argument --" + std::string(name_) + ": " +
+                    error.message;
+  }
+
+  /* the deferred conversion of a Lazy, the error as parse() would have
+   * reported it from where the text was read */
+  static std::optional<value_type> resolve_(const Argument &self,
+                                            std::string_view value,
+                                            const Detail::Origin &at,
+                                            Error &error) {
+    const auto &arg = static_cast<const TypedArgument &>(self);
+    std::optional<value_type> out;
+    if (arg.convert_(value, out, error)) {
+      return out;
+    }
+    arg.value_error_(value, error);
+    if (at.source == Source::environment) {
+      error.message = "Environment variable " + std::string(arg.env_) +
+                      ": " + error.message;
+      error.offset = 0;
+    } else if (at.source == Source::config) {
+      error.message = "Config file: " + error.message;
+      error.offset = 0;
+    } else {
+      error.argv_index = at.argv_index;
+      error.offset += at.offset;
+    }
+    return std::nullopt;
+  }
+
+  static void destroy_(Argument &self) {
+    static_cast<TypedArgument &>(self).~TypedArgument();
+  }
+
+  static void render_default_(const Argument &self, std::ostream &out) {
+    const auto &arg = static_cast<const TypedArgument &>(self);
+    if constexpr (is_lazy) {
+      if (arg.default_val_.value_) {
+        render_value_(*arg.default_val_.value_, out);
+      }
+    } else if constexpr (is_reloadable) {
+      arg.render_(arg.default_val_.load(), out);
+    } else {
+      arg.render_(arg.default_val_, out);
+    }
+  }
+
+  void render_(const value_type &value, std::ostream &out) const {
+    if constexpr (is_list) {
+      for (size_t i{0}; i < value.size(); ++i) {
+        if (i > 0) {
+          out << (delimiter_ ? delimiter_ : ',');
+        }
+        render_value_(value[i], out);
+      }
+    } else {
+      render_value_(value, out);
+    }
+  }
+
+  template <typename V>
+  static void render_value_(const V &value, std::ostream &out) {
+    if constexpr (std::is_integral_v<V> && sizeof(V) == 1 &&
+                  !std::is_same_v<V, char> && !std::is_same_v<V, bool>) {
+      out << +value; // int8_t / uint8_t print as numbers
+    } else if constexpr (Detail::IsDuration<V>::value) {
+      Detail::write_duration(out, value);
+    } else if constexpr (Detail::IsStreamable<V>::value) {
+      out << value;
+    } else {
+      out << "custom";
+    }
+  }
+
+  bool store_list_(value_type &list, std::string_view value, bool first,
+                   Error &error) const {
+    if (first) {
+      list.clear(); // the first occurrence replaces the default
+    }
+    return Detail::split_list(
+        list, value, delimiter_, error, [&](auto item, size_t i) {
+          if (choice_count_ > 0 && !check_choice_(item, error)) {
+            Detail::element_error(item, i, error);
+            return std::optional<element_type>();
+          }
+          if (!str_to_T_) {
+            return Detail::convert_element<element_type>(item, i, name_,
+                                                         error);
+          }
+          std::optional<element_type> converted = str_to_T_(item, error);
+          if (!converted) {
+            Detail::element_error(item, i, error);
+          }
+          return converted;
+        });
+  }
+
+  static void restart_(const Argument &self, void *target) {
+    // copy assignment keeps the capacity of strings and lists
+    *static_cast<T *>(target) =
+        static_cast<const TypedArgument &>(self).default_val_;
+  }
+
+  static void construct_(const Argument &self, void *target) {
+    new (target) T(static_cast<const TypedArgument &>(self).default_val_);
+  }
+
+  static void destroy_value_(void *target) { static_cast<T *>(target)->~T(); }
+
+  static void publish_(const Argument &self, const void *staged) {
+    if constexpr (is_reloadable) {
+      // a snapshot is shared, not copied
+      *static_cast<const TypedArgument &>(self).value_ptr_() =
+          *static_cast<const T *>(staged);
+    }
+  }
+
+  static void notify_(const Argument &self) {
+    if constexpr (is_reloadable) {
+      static_cast<const TypedArgument &>(self).value_ptr_()->notify_();
+    }
+  }
+
+  static constexpr ArgumentOps ops_{
+      &store_,
+      &render_default_,
+      &destroy_,
+      &restart_,
+      &construct_,
+      &destroy_value_,
+      is_reloadable ? &publish_ : nullptr,
+      is_reloadable ? &notify_ : nullptr,
+      &Detail::TypeTag<T>::id,
+      sizeof(T),
+      alignof(T)};
+
+  template <typename Func> void set_converter_(Func &&conv) {
+    if constexpr (std::is_invocable_r_v<Expected<element_type>, Func,
+                                        std::string_view>) {
+      str_to_T_.emplace(std::forward<Func>(conv));
+    } else {
+      str_to_T_.emplace([conv = std::forward<Func>(conv)](std::string_view s) {
+        return conv(std::string(s));
+      });
+    }
+  }
+};
+
+class FlagArgument : public Argument {
+public:
+  FlagArgument(Arena &arena, std::string_view name,
+               std::string_view short_name, bool *value_ptr)
+      : Argument(&ops_, ArgKind::flag, arena, name, short_name, value_ptr,
+                 false) {
+    *value_ptr = false;
+  }
+
+  FlagArgument &help(std::string_view help_text) {
+    set_help_(help_text);
+    return *this;
+  }
+
+  FlagArgument &operator|(const char *help_text) {
+    set_help_(help_text);
+    return *this;
+  }
+
+  FlagArgument &operator|(const std::string &help_text) {
+    set_help_(help_text);
+    return *this;
+  }
+
+private:
+  static bool store_(const Argument &, void *target, std::string_view, bool,
+                     const Detail::Origin &, Error &) {
+    *static_cast<bool *>(target) = true;
+    return true;
+  }
+
+  static void render_default_(const Argument &, std::ostream &) {}
+
+  static void destroy_(Argument &self) {
+    static_cast<FlagArgument &>(self).~FlagArgument();
+  }
+
+  static void restart_(const Argument &, void *target) {
+    *static_cast<bool *>(target) = false;
+  }
+
+  static void construct_(const Argument &, void *target) {
+    new (target) bool(false);
+  }
+
+  static void destroy_value_(void *) {}
+
+  static constexpr ArgumentOps ops_{
+      &store_,     &render_default_, &destroy_,
+      &restart_,   &construct_,      &destroy_value_,
+      nullptr,     nullptr,          &Detail::TypeTag<bool>::id,
+      sizeof(bool), alignof(bool)};
+};
+
+/*
+ * A value converted when it is first read rather than during parse():
+ * the parse records the raw text and where it was given, get() runs the
+ * argument's choices() and converter on it once and keeps the result.
+ * Meant for options with costly converters that most runs never read:
+ *
+ *   Incanti::Lazy<Schema> schema;
+ *   parser >> arg("schema", &schema) | load_schema;
+ *   ...
+ *   if (validate) check(*schema); // converted here, or a ParseError
+ *
+ * The text is a view into argv, the command line string or a mapped file
+ * like Parser::positional_views(), so read the value before the next
+ * parse() or reset(), while the parser lives. Reading it is not
+ * synchronized; convert from one thread at a time.
+ */
+template <typename T> class Lazy {
+public:
+  Lazy() = default;
+  /* holds an already converted value, as a default does */
+  Lazy(T value) : value_(std::move(value)) {}
+
+  /* given in the last parse, or defaulted */
+  bool has_value() const { return convert_ || value_.has_value(); }
+  /* given and not read yet */
+  bool pending() const { return convert_ != nullptr; }
+
+  /* the text as given, empty for a default */
+  std::string_view raw() const { return raw_; }
+  /* the token it was in, counted like argv; -1 outside the command line */
+  int argv_index() const { return at_.argv_index; }
+
+  /* converts on the first call; a rejection is kept and returned again,
+   * placed where the text was on the command line */
+  Expected<void> convert() const {
+    if (convert_) {
+      auto convert = std::exchange(convert_, nullptr);
+      std::optional<T> converted = convert(*arg_, raw_, at_, error_);
+      if (converted) {
+        value_ = std::move(converted);
+      }
+    }
+    if (error_.code != ErrorCode::none) {
+      return Unexpected{error_};
+    }
+    if (!value_) {
+      return Unexpected{Error{ErrorCode::other, -1, 0, {},
+                              "Lazy value read without a value or default",
+                              {}}};
+    }
+    return {};
+  }
+
+  /* the converted value, raising a ParseError when it was rejected */
+  const T &get() const {
+    Expected<void> converted = convert();
+    if (!converted) {
+      Detail::raise(ParseError(std::move(converted.error())));
+    }
+    return *value_;
+  }
+  const T &operator*() const { return get(); }
+  const T *operator->() const { return &get(); }
+
+private:
+  using Convert = std::optional<T> (*)(const Argument &, std::string_view,
+                                       const Detail::Origin &, Error &);
+
+  mutable std::optional<T> value_;
+  mutable Error error_; // the rejection, code none otherwise
+  // the recorded text, converted by convert_ through arg_ while set
+  std::string_view raw_;
+  Detail::Origin at_;
+  const Argument *arg_ = nullptr;
+  mutable Convert convert_ = nullptr;
+
+  template <typename> friend class TypedArgument;
+
+  void defer_(const Argument &arg, std::string_view raw,
+              const Detail::Origin &at, Convert convert) {
+    value_.reset();
+    error_ = {};
+    raw_ = raw;
+    at_ = at;
+    arg_ = &arg;
+    convert_ = convert;
+  }
+};
+
+namespace Detail {
+/* T fits a std::atomic that needs no lock */
+template <typename T, bool = std::is_trivially_copyable_v<T>>
+struct IsInlineAtomic : std::false_type {};
+
+template <typename T>
+struct IsInlineAtomic<T, true>
+    : std::bool_constant<std::atomic<T>::is_always_lock_free> {};
+
+/*
+ * An immutable T behind a shared_ptr that readers copy without ever
+ * waiting. A reader counts itself in on one of two counters for as long
+ * as the copy takes; a store swaps the holder, then waits for both
+ * counters to drain before reusing the one it replaced for the next
+ * store, flipping the epoch in between so new readers never hold it up.
+ * Only the first store allocates a holder.
+ */
+template <typename T> class SharedValue {
+public:
+  explicit SharedValue(std::shared_ptr<const T> value)
+      : current_(new Holder_{std::move(value)}) {}
+  SharedValue(const SharedValue &) = delete;
+  SharedValue &operator=(const SharedValue &) = delete;
+  ~SharedValue() {
+    delete current_.load();
+    delete spare_;
+  }
+
+  std::shared_ptr<const T> load() const {
+    std::atomic<std::uint32_t> &readers = readers_[epoch_.load() & 1];
+    readers.fetch_add(1);
+    std::shared_ptr<const T> value = current_.load()->value;
+    readers.fetch_sub(1, std::memory_order_release);
+    return value;
+  }
+
+  void store(std::shared_ptr<const T> value) {
+    std::lock_guard<std::mutex> lock(store_mutex_);
+    Holder_ *next = spare_ ? spare_ : new Holder_;
+    next->value = std::move(value);
+    Holder_ *replaced = current_.exchange(next);
+    for (int flip{0}; flip < 2; ++flip) {
+      const std::uint32_t epoch = epoch_.fetch_add(1) & 1;
+      while (readers_[epoch].load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+      }
+    }
+    replaced->value.reset(); // readers that copied it keep theirs
+    spare_ = replaced;
+  }
+
+private:
+  struct Holder_ {
+    std::shared_ptr<const T> value;
+  };
+
+  std::atomic<Holder_ *> current_;
+  Holder_ *spare_ = nullptr; // no reader can reach it, under store_mutex_
+  std::atomic<std::uint32_t> epoch_{0};
+  mutable std::atomic<std::uint32_t> readers_[2] = {};
+  std::mutex store_mutex_;
+};
+} // namespace Detail
+
+/*
+ * A value a ConfigWatcher may replace while other threads read it, and
+ * reads never wait: a T that std::atomic holds without a lock (int,
+ * double, ByteSize, durations) is a single atomic load; anything else
+ * (strings, lists) is an immutable snapshot, a std::shared_ptr copied
+ * out without a lock and kept alive for as long as a reader holds it.
+ *
+ *   Incanti::Reloadable<int> threads{4};
+ *   parser >> arg("threads", &threads) | on_change([&](int n) { ... });
+ *   ...
+ *   pool.resize(threads.load());
+ *
+ * Copies carry the value only, not the change callback.
+ */
+template <typename T> class Reloadable {
+public:
+  /* held in a lock-free std::atomic<T> rather than a snapshot */
+  static constexpr bool is_inline = Detail::IsInlineAtomic<T>::value;
+
+  Reloadable() : Reloadable(T{}) {}
+  Reloadable(T value) : value_(wrap_(std::move(value))) {}
+  Reloadable(const Reloadable &other) : value_(other.share_()) {}
+
+  /* publishes the value of other, keeping this one's callback */
+  Reloadable &operator=(const Reloadable &other) {
+    if (this != &other) {
+      publish_(other.share_());
+    }
+    return *this;
+  }
+
+  /* the current value */
+  T load() const {
+    if constexpr (is_inline) {
+      return value_.load(std::memory_order_acquire);
+    } else {
+      return *value_.load();
+    }
+  }
+
+  /* the current value without copying it; an allocation for inline types,
+   * where load() is cheaper */
+  std::shared_ptr<const T> snapshot() const {
+    if constexpr (is_inline) {
+      return std::make_shared<const T>(load());
+    } else {
+      return value_.load();
+    }
+  }
+
+  void store(T value) { publish_(wrap_(std::move(value))); }
+
+  /* how many values were stored after the first, to notice a change
+   * without comparing */
+  std::uint64_t version() const {
+    return version_.load(std::memory_order_acquire);
+  }
+
+  /* callback(const T &) after a ConfigWatcher stores a new value */
+  template <typename Callback> void on_change(Callback &&callback) {
+    on_change_ = std::forward<Callback>(callback);
+  }
+
+private:
+  using Stored = std::conditional_t<is_inline, T, std::shared_ptr<const T>>;
+
+  std::conditional_t<is_inline, std::atomic<T>, Detail::SharedValue<T>>
+      value_;
+  std::atomic<std::uint64_t> version_{0};
+  std::function<void(const T &)> on_change_;
+
+  template <typename> friend class TypedArgument;
+
+  static Stored wrap_(T value) {
+    if constexpr (is_inline) {
+      return value;
+    } else {
+      return std::make_shared<const T>(std::move(value));
+    }
+  }
+
+  Stored share_() const {
+    if constexpr (is_inline) {
+      return load();
+    } else {
+      return value_.load();
+    }
+  }
+
+  void publish_(Stored value) {
+    if constexpr (is_inline) {
+      value_.store(value, std::memory_order_release);
+    } else {
+      value_.store(std::move(value));
+    }
+    version_.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  void notify_() const {
+    if (!on_change_) {
+      return;
+    }
+    if constexpr (is_inline) {
+      on_change_(load());
+    } else {
+      on_change_(*value_.load());
+    }
+  }
+};
+
+/* memory held by a parser's schema */
+struct MemoryUsage {
+  size_t options = 0;
+  size_t arena_bytes = 0; // argument objects, names and help text
+  size_t index_bytes = 0; // name index and registration tables
+  size_t reserved_bytes = 0; // arena blocks including unused tail
+
+  size_t total() const { return arena_bytes + index_bytes; }
+  double per_option() const {
+    return options ? static_cast<double>(total()) / options : 0.0;
+  }
+};
+
+/* one option in Stats */
+struct OptionStats {
+  std::string name;
+  std::uint64_t conversions = 0; // values stored, from any source
+  std::uint64_t convert_ns = 0;  // converting, validating and storing them
+};
+
+/*
+ * Where a Parser spent its time, from Parser::stats(). Collected only in
+ * builds with INCANTI_STATS=1; elsewhere every field stays zero.
+ * Allocations are counted through note_allocation().
+ */
+struct Stats {
+  static constexpr bool enabled = INCANTI_STATS != 0;
+
+  std::uint64_t registrations = 0;   // arg(), flag() and command() calls
+  std::uint64_t registration_ns = 0; // in those calls and index builds
+  std::uint64_t parses = 0;
+  std::uint64_t parse_ns = 0;
+  std::uint64_t tokens = 0;  // read from argv, strings and response files
+  std::uint64_t lookups = 0; // name lookups in the option index
+  std::uint64_t allocations = 0;
+  std::uint64_t allocated_bytes = 0;
+  std::vector<OptionStats> options; // in registration order
+
+  /* one JSON object, options as an array of objects */
+  std::string json() const {
+    std::string out = "{";
+    auto field = [&out](const char *name, std::uint64_t value) {
+      out.append("\"").append(name).append("\":");
+      out.append(std::to_string(value)).append(",");
+    };
+    field("registrations", registrations);
+    field("registration_ns", registration_ns);
+    field("parses", parses);
+    field("parse_ns", parse_ns);
+    field("tokens", tokens);
+    field("lookups", lookups);
+    field("allocations", allocations);
+    field("allocated_bytes", allocated_bytes);
+    out.append("\"options\":[");
+    for (size_t i{0}; i < options.size(); ++i) {
+      out.append(i ? ",{\"name\":\"" : "{\"name\":\"");
+      for (char c : options[i].name) {
+        if (c == '"' || c == '\\') {
+          out += '\\';
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+          const char *hex = "0123456789abcdef";
+          out.append("\\u00").append(1, hex[c >> 4]).append(1, hex[c & 15]);
+          continue;
+        }
+        out += c;
+      }
+      out.append("\",");
+      field("conversions", options[i].conversions);
+      out.append("\"convert_ns\":")
+          .append(std::to_string(options[i].convert_ns))
+          .append("}");
+    }
+    out.append("]}");
+    return out;
+  }
+};
+
+/*
+ * A fixed set of threads for Schema::parse_batch(). Every run() splits the
+ * work into one contiguous lane per thread; a thread that empties its own
+ * lane steals chunks from the others, so a few slow items do not leave
+ * the rest of the pool idle. One run() at a time.
+ */
+class WorkerPool {
+public:
+  /* threads including the caller of run(), 0 for one per core */
+  explicit WorkerPool(size_t threads = 0) {
+    if (threads == 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    lane_count_ = threads;
+    lanes_ = std::make_unique<Lane[]>(threads);
+    threads_.reserve(threads - 1);
+    for (size_t lane{1}; lane < threads; ++lane) {
+      threads_.emplace_back([this, lane] { loop_(lane); });
+    }
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &thread : threads_) {
+      thread.join();
+    }
+  }
+
+  size_t size() const { return lane_count_; }
+
+  /* fn(i) for every i in [0, count), returns once all calls are done; the
+   * first exception thrown by fn is rethrown here */
+  template <typename Fn> void run(size_t count, Fn &&fn) {
+    if (count == 0) {
+      return;
+    }
+    // chunks small enough to balance, large enough to keep the lane
+    // counters out of the way
+    grain_ = std::clamp<size_t>(count / (lane_count_ * 32), 1, 256);
+    for (size_t lane{0}; lane < lane_count_; ++lane) {
+      lanes_[lane].next.store(count * lane / lane_count_,
+                              std::memory_order_relaxed);
+      lanes_[lane].end = count * (lane + 1) / lane_count_;
+    }
+    job_ = &fn;
+    call_ = [](void *job, size_t i) {
+      (*static_cast<std::remove_reference_t<Fn> *>(job))(i);
+    };
+#if INCANTI_EXCEPTIONS
+    error_ = nullptr;
+#endif
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      busy_ = threads_.size();
+      ++generation_;
+    }
+    wake_.notify_all();
+    work_(0);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_.wait(lock, [this] { return busy_ == 0; });
+    }
+#if INCANTI_EXCEPTIONS
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+#endif
+  }
+
+private:
+  struct alignas(64) Lane {
+    std::atomic<size_t> next{0};
+    size_t end{0};
+  };
+
+  size_t lane_count_;
+  std::unique_ptr<Lane[]> lanes_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  size_t busy_ = 0;
+  std::uint64_t generation_ = 0;
+  bool stop_ = false;
+  // the current run, published to the threads under mutex_
+  size_t grain_ = 1;
+  void *job_ = nullptr;
+  void (*call_)(void *, size_t) = nullptr;
+#if INCANTI_EXCEPTIONS
+  std::exception_ptr error_;
+#endif
+
+  void loop_(size_t lane) {
+    std::uint64_t seen{0};
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) {
+          return;
+        }
+        seen = generation_;
+      }
+      work_(lane);
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--busy_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+
+  /* own lane first, then the others in turn */
+  void work_(size_t lane) {
+    for (size_t k{0}; k < lane_count_; ++k) {
+      Lane &from = lanes_[(lane + k) % lane_count_];
+      for (;;) {
+        size_t begin = from.next.fetch_add(grain_, std::memory_order_relaxed);
+        if (begin >= from.end) {
+          break;
+        }
+        size_t end = std::min(begin + grain_, from.end);
+        for (size_t i{begin}; i < end; ++i) {
+#if INCANTI_EXCEPTIONS
+          try {
+            call_(job_, i);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) {
+              error_ = std::current_exception();
+            }
+          }
+#else
+          call_(job_, i);
+#endif
+        }
+      }
+    }
+  }
+};
+
+class ParseResult;
+struct BatchResult;
+
+/*
+ * The registered options, their indexes and the layering settings. A Parser
+ * builds one as arguments are registered; Parser::share() freezes it, after
+ * which any number of threads may call parse() on it at once without
+ * locking. Each call converts into its own ParseResult and never touches
+ * the variables bound at registration. Custom converters then have to be
+ * safe to call concurrently.
+ */
+class Schema : public std::enable_shared_from_this<Schema> {
+public:
+  Schema(const Schema &) = delete;
+  Schema &operator=(const Schema &) = delete;
+
+  ~Schema() {
+    for (Argument *arg : args_) {
+      arg->destroy();
+    }
+  }
+
+  ParseResult parse(int argc, char *argv[]) const;
+  ParseResult parse(std::string_view command_line) const;
+
+  /* parse into an existing result, reusing its storage: a warm result
+   * does not allocate unless a value type needs to */
+  void parse(int argc, char *argv[], ParseResult &result) const;
+  void parse(std::string_view command_line, ParseResult &result) const;
+
+  /* the same without exceptions: a failed parse returns its Error, and a
+   * result that was parsed into is left partly filled */
+  Expected<ParseResult> try_parse(int argc, char *argv[]) const;
+  Expected<ParseResult> try_parse(std::string_view command_line) const;
+  Expected<void> try_parse(int argc, char *argv[], ParseResult &result) const;
+  Expected<void> try_parse(std::string_view command_line,
+                           ParseResult &result) const;
+
+  /*
+   * Parse many command lines at once across a WorkerPool. Items are
+   * command line strings (anything convertible to std::string_view) or
+   * argv vectors (std::vector<char *> and the like, program name first).
+   * Results come back in input order; every item shares this schema.
+   */
+  template <typename Items>
+  std::vector<BatchResult> parse_batch(const Items &items,
+                                       WorkerPool &pool) const;
+
+  /* the same on a pool of `threads` threads made for this call */
+  template <typename Items>
+  std::vector<BatchResult> parse_batch(const Items &items,
+                                       size_t threads = 0) const {
+    WorkerPool pool(threads);
+    return parse_batch(items, pool);
+  }
+
+  size_t size() const { return args_.size(); }
+
+  /* slot of a long option name, npos when unknown */
+  std::uint32_t slot(std::string_view name) const {
+    return index_.find(OptionIndex::Kind::long_name, name);
+  }
+
+  const Argument &argument(std::uint32_t slot) const { return *args_[slot]; }
+
+  /*
+   * The help screen, rendered on first use and kept: a sealed schema
+   * renders it once per width. Width 0 is the terminal's ($COLUMNS, then
+   * the tty, then 80). The view stays valid while the schema lives,
+   * unsealed ones until the next call.
+   */
+  std::string_view help(size_t width = 0) const {
+    return help_(program_name_, width);
+  }
+
+  /* the help screen in one write, straight to fd 1 for std::cout */
+  void print_help(std::ostream &out = std::cout) const {
+    print_help_(program_name_, out);
+  }
+
+  /*
+   * Shell completion. words are the command line after the program name,
+   * the last one the word being completed (empty for a new word); the
+   * candidates are appended to out, one per line, and counted. Options
+   * complete from a "-" prefix, values from choices() after an option
+   * that takes one, also as --name=value. Nothing is printed where the
+   * shell should fall back to file names.
+   */
+  size_t complete(int count, char *words[], std::string &out) const;
+
+  /* a bash, zsh or fish script wiring the shell to `program __complete`,
+   * which the program answers once Parser::completion() is on; program
+   * defaults to the schema's program name */
+  std::string completion_script(Shell shell,
+                                std::string_view program = {}) const;
+
+  static constexpr std::uint32_t npos = OptionIndex::npos;
+
+private:
+  std::string program_name_;
+  std::string program_desc_;
+
+  // schema storage: every argument lives in the arena, args_ is the slot
+  // table in registration order
+  Arena arena_;
+  std::vector<Argument *> args_;
+  Detail::SlotTable long_names_;
+  Detail::SlotTable short_names_;
+
+  bool response_files_ = false;
+  size_t response_depth_ = 8;
+
+  OptionIndex index_;
+  ShortIndex shorts_;
+  std::vector<std::uint32_t> required_slots_;
+  std::vector<std::uint32_t> restart_slots_;
+  std::vector<std::uint32_t> env_slots_;
+  Detail::SlotTable env_names_;
+  // first bytes of the bound names, most entries are skipped on this alone
+  std::array<std::uint64_t, 4> env_first_{};
+  char **environment_ = nullptr;
+  std::vector<std::string> config_paths_;
+  std::vector<const std::string *> config_path_ptrs_;
+  // argument bound to each config path pointer, a ParseResult reads the
+  // path from its own value of that argument
+  std::vector<std::uint32_t> config_path_slots_;
+  // where each value sits in the storage of a ParseResult
+  std::vector<size_t> offsets_;
+  size_t storage_size_ = 0;
+  size_t storage_align_ = 1;
+  bool index_dirty_ = true;
+  bool sealed_ = false;
+
+  // subcommands, only their names until one is selected (Parser::command)
+  struct Command_ {
+    std::string_view name;
+    std::string_view description;
+    std::function<void(Parser &)> setup;
+  };
+  std::vector<Command_> commands_;
+  Detail::SlotTable command_names_;
+  // the schema this one is a subcommand of, for help
+  const Schema *parent_ = nullptr;
+
+  // the hidden `prog __complete words...` mode of Parser::parse(), opt-in
+  // so that a first positional spelled __complete keeps its meaning
+  bool complete_mode_ = false;
+  mutable Detail::CompletionIndex completion_;
+  mutable bool completion_dirty_ = true;
+
+  // option and command names for "did you mean", built on the first miss
+  mutable Detail::NameTree long_tree_;
+  mutable Detail::NameTree short_tree_;
+  mutable Detail::NameTree command_tree_;
+  mutable bool trees_dirty_ = true;
+
+#if INCANTI_STATS
+  std::uint64_t registrations_ = 0;
+  std::uint64_t registration_ns_ = 0;
+#endif
+
+  // rendered help screens, one per width and program name
+  struct HelpCache_ {
+    size_t width;
+    std::string program;
+    std::string text;
+  };
+  mutable std::mutex cache_mutex_;
+  mutable std::deque<HelpCache_> help_cache_; // references stay valid
+
+  friend class Parser;
+  friend class ParseResult;
+  friend class ConfigWatcher;
+
+  Schema(const std::string &program_name, const std::string &program_desc)
+      : program_name_(program_name), program_desc_(program_desc) {}
+
+  template <typename A, typename T>
+  A &add_arg_(std::string_view name, std::string_view short_name,
+              T *value_ptr) {
+#if INCANTI_STATS
+    const std::uint64_t start = Detail::now_ns();
+#endif
+    check_new_(name, short_name);
+    auto *arg = arena_.create<A>(arena_, arena_.intern(name),
+                                 arena_.intern(short_name), value_ptr);
+    add_(arg);
+#if INCANTI_STATS
+    ++registrations_;
+    registration_ns_ += Detail::now_ns() - start;
+#endif
+    return *arg;
+  }
+
+  bool has_config_() const {
+    return !config_paths_.empty() || !config_path_ptrs_.empty();
+  }
+
+  std::string_view help_(std::string_view program, size_t width) const {
+    if (width == 0) {
+      width = Detail::terminal_width();
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (!sealed_) {
+      help_cache_.clear(); // arguments may still change
+    }
+    for (const HelpCache_ &cached : help_cache_) {
+      if (cached.width == width && cached.program == program) {
+        return cached.text;
+      }
+    }
+    HelpCache_ &cached =
+        help_cache_.emplace_back(HelpCache_{width, std::string(program), {}});
+    render_help_(program, width, cached.text);
+    return cached.text;
+  }
+
+  void render_help_(std::string_view program, size_t width,
+                    std::string &out) const {
+    auto by_name = [](const Argument *a, const Argument *b) {
+      return a->name() < b->name();
+    };
+    std::vector<const Argument *> sorted(args_.begin(), args_.end());
+    std::sort(sorted.begin(), sorted.end(), by_name);
+
+    Detail::HelpLayout layout(width);
+    if (!commands_.empty()) {
+      layout.section("Commands");
+      for (const Command_ &command : commands_) {
+        layout.add(command.name, command.description);
+      }
+      layout.section("Options");
+    }
+    std::string spec;
+    std::string text;
+    std::ostringstream scratch;
+    for (const Argument *arg : sorted) {
+      arg->help_columns_(spec, text, scratch);
+      layout.add(spec, text);
+    }
+    // options of the enclosing commands are accepted after the verb too
+    sorted.clear();
+    for (const Schema *outer = parent_; outer; outer = outer->parent_) {
+      for (const Argument *arg : outer->args_) {
+        if (arg->name() != "help") {
+          sorted.push_back(arg);
+        }
+      }
+    }
+    std::sort(sorted.begin(), sorted.end(), by_name);
+    if (!sorted.empty()) {
+      layout.section("Global options");
+    }
+    for (const Argument *arg : sorted) {
+      arg->help_columns_(spec, text, scratch);
+      layout.add(spec, text);
+    }
+    layout.render(out, program, program_desc_,
+                  commands_.empty() ? " [options]"
+                                    : " [options] <command> [<args>]");
+  }
+
+  void build_completion_() const {
+    completion_.clear();
+    for (std::uint32_t slot{0}; slot < args_.size(); ++slot) {
+      const Argument *arg = args_[slot];
+      completion_.add_option("--", arg->name(), slot);
+      if (!arg->short_name().empty()) {
+        completion_.add_option("-", arg->short_name(), slot);
+      }
+      if (arg->choice_count_ > 0) {
+        completion_.add_values(slot, arg->choices_, arg->choice_count_);
+      }
+    }
+    for (const Command_ &command : commands_) {
+      completion_.add_option("", command.name, Detail::no_slot);
+    }
+    completion_.finish();
+    completion_dirty_ = false;
+  }
+
+  /* the option a word like --name, -n or -vn hands the next word to,
+   * no_slot when it does not take one; t looks names up like a Target */
+  template <typename Lookup>
+  static std::uint32_t value_option_(const Lookup &t, std::string_view word) {
+    std::uint32_t slot{Detail::no_slot};
+    if (word.size() > 2 && word[0] == '-' && word[1] == '-') {
+      if (word.find('=') != std::string_view::npos) {
+        return Detail::no_slot;
+      }
+      slot = t.find_long(word.substr(2));
+    } else if (word.size() > 1 && word[0] == '-') {
+      slot = t.find_short(word.substr(1));
+      if (slot == Detail::no_slot) {
+        // a cluster of flags ending in an option: -vm
+        for (size_t j{1}; j + 1 < word.size(); ++j) {
+          std::uint32_t flag = t.find_char(word[j]);
+          if (flag == Detail::no_slot || !t.is_flag(flag)) {
+            return Detail::no_slot;
+          }
+        }
+        slot = t.find_char(word.back());
+      }
+    }
+    return slot != Detail::no_slot && !t.is_flag(slot) ? slot
+                                                        : Detail::no_slot;
+  }
+
+  std::uint32_t value_option_(std::string_view word) const {
+    return value_option_(Lookup_{*this}, word);
+  }
+
+  void build_trees_() const {
+    long_tree_.clear();
+    short_tree_.clear();
+    command_tree_.clear();
+    for (const Argument *arg : args_) {
+      long_tree_.add(arg->name());
+      if (!arg->short_name().empty()) {
+        short_tree_.add(arg->short_name());
+      }
+    }
+    for (const Command_ &command : commands_) {
+      command_tree_.add(command.name);
+    }
+    trees_dirty_ = false;
+  }
+
+  /* option names close to near.unknown(), offered with their dashes or as
+   * config keys (long names only) */
+  void near_options_(Detail::NearMatches &near, bool keys = false) const {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (trees_dirty_) {
+      build_trees_();
+    }
+    near.search(long_tree_, keys ? "" : "--");
+    if (!keys) {
+      near.search(short_tree_, "-");
+    }
+  }
+
+  void near_commands_(Detail::NearMatches &near) const {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (trees_dirty_) {
+      build_trees_();
+    }
+    near.search(command_tree_, {});
+  }
+
+  void print_help_(std::string_view program, std::ostream &out) const {
+    std::string_view text = help_(program, 0);
+    if (&out == &std::cout) {
+      Detail::write_stdout(text);
+    } else {
+      out.write(text.data(), static_cast<std::streamsize>(text.size()));
+      out.flush();
+    }
+  }
+
+  MemoryUsage memory_usage_() const {
+    MemoryUsage usage;
+    usage.options = args_.size();
+    usage.arena_bytes = arena_.used();
+    usage.reserved_bytes = arena_.reserved();
+    usage.index_bytes = index_.memory_usage() + shorts_.memory_usage() +
+                        long_names_.memory_usage() +
+                        short_names_.memory_usage() +
+                        completion_.memory_usage() +
+                        long_tree_.memory_usage() +
+                        short_tree_.memory_usage() +
+                        command_tree_.memory_usage() +
+                        command_names_.memory_usage() +
+                        commands_.capacity() * sizeof(Command_) +
+                        args_.capacity() * sizeof(Argument *);
+    return usage;
+  }
+
+  std::string_view long_name_of_(std::uint32_t slot) const {
+    return args_[slot]->name();
+  }
+
+  std::string_view short_name_of_(std::uint32_t slot) const {
+    return args_[slot]->short_name();
+  }
+
+  void check_new_(std::string_view name, std::string_view short_name) const {
+    if (sealed_) {
+      Detail::raise(ParseError("Cannot register --" + std::string(name) +
+                               ": parser schema is sealed"));
+    }
+
+    auto long_of = [this](std::uint32_t s) { return long_name_of_(s); };
+    if (long_names_.find(name, long_of) != Detail::SlotTable::npos) {
+      Detail::raise(
+          ParseError("Duplicate argument name: --" + std::string(name)));
+    }
+
+    auto short_of = [this](std::uint32_t s) { return short_name_of_(s); };
+    std::uint32_t owner = short_name.empty()
+                              ? Detail::SlotTable::npos
+                              : short_names_.find(short_name, short_of);
+    if (owner != Detail::SlotTable::npos) {
+      Detail::raise(ParseError("Duplicate short option name: " +
+                               std::string(short_name) +
+                               " (already used by --" +
+                               args_[owner]->get_name() + ")"));
+    }
+  }
+
+  void add_(Argument *arg) {
+    auto slot = static_cast<std::uint32_t>(args_.size());
+    args_.push_back(arg);
+    long_names_.insert(slot, arg->name(),
+                       [this](std::uint32_t s) { return long_name_of_(s); });
+    if (!arg->short_name().empty()) {
+      short_names_.insert(
+          slot, arg->short_name(),
+          [this](std::uint32_t s) { return short_name_of_(s); });
+    }
+    index_dirty_ = true;
+  }
+
+  void build_index_() {
+    if (!index_dirty_) {
+      return;
+    }
+#if INCANTI_STATS
+    const std::uint64_t start = Detail::now_ns();
+#endif
+    std::vector<OptionIndex::Key> keys;
+    std::vector<ShortIndex::Key> short_keys;
+    keys.reserve(args_.size() * 2);
+    required_slots_.clear();
+    restart_slots_.clear();
+    env_slots_.clear();
+    env_names_.clear();
+    env_first_ = {};
+    offsets_.clear();
+    storage_size_ = 0;
+    storage_align_ = 1;
+    for (std::uint32_t slot{0}; slot < args_.size(); ++slot) {
+      const Argument *arg = args_[slot];
+      if (arg->is_required()) {
+        required_slots_.push_back(slot);
+      }
+      if (!arg->env_name().empty()) {
+        add_env_(slot);
+      }
+      // a Lazy must not keep viewing the tokens of an earlier parse
+      if (arg->is_list() || arg->is_lazy() || !arg->env_name().empty()) {
+        restart_slots_.push_back(slot);
+      }
+      keys.push_back({arg->name(), OptionIndex::Kind::long_name, slot});
+      if (!arg->short_name().empty()) {
+        keys.push_back(
+            {arg->short_name(), OptionIndex::Kind::short_name, slot});
+        short_keys.push_back({arg->short_name(), slot});
+      }
+      const size_t align = arg->value_align();
+      storage_size_ = (storage_size_ + align - 1) / align * align;
+      offsets_.push_back(storage_size_);
+      storage_size_ += arg->value_size();
+      storage_align_ = std::max(storage_align_, align);
+    }
+    index_.build(keys);
+    shorts_.build(std::move(short_keys));
+    index_dirty_ = false;
+    completion_dirty_ = true;
+    trees_dirty_ = true;
+    resolve_config_paths_();
+#if INCANTI_STATS
+    registration_ns_ += Detail::now_ns() - start;
+#endif
+  }
+
+  void resolve_config_paths_() {
+    config_path_slots_.clear();
+    for (const std::string *path : config_path_ptrs_) {
+      std::uint32_t bound = Detail::no_slot;
+      for (std::uint32_t slot{0}; slot < args_.size(); ++slot) {
+        if (args_[slot]->value_ == path &&
+            args_[slot]->holds<std::string>()) {
+          bound = slot;
+          break;
+        }
+      }
+      config_path_slots_.push_back(bound);
+    }
+  }
+
+  void add_env_(std::uint32_t slot) {
+    auto env_of = [this](std::uint32_t s) { return args_[s]->env_name(); };
+    std::string_view env_name = args_[slot]->env_name();
+    std::uint32_t other = env_names_.find(env_name, env_of);
+    if (other != Detail::SlotTable::npos) {
+      Detail::raise(ParseError("Environment variable " +
+                               std::string(env_name) + " bound to both --" +
+                               args_[other]->get_name() + " and --" +
+                               args_[slot]->get_name()));
+    }
+    env_names_.insert(slot, env_name, env_of);
+    env_slots_.push_back(slot);
+    const auto first =
+        static_cast<unsigned char>(env_name.empty() ? 0 : env_name[0]);
+    env_first_[first >> 6] |= std::uint64_t{1} << (first & 63);
+  }
+
+  /*
+   * The parse itself, shared by Parser and ParseResult. Sink holds the
+   * per-call state and decides where values go:
+   *   source(slot) -> Source &, value(slot) -> void * (a T), touch(slot)
+   *   (first value of a parse), mapped(), positional(token, error) (false
+   *   to stop, see scan_tokens()), help(),
+   *   converted(slot, ns) (INCANTI_STATS builds)
+   * argv_index and offset place the value on the command line for Lazy.
+   */
+  template <typename Sink>
+  bool store_(Sink &sink, std::uint32_t slot, std::string_view value,
+              Source source, Error &error, int argv_index = -1,
+              size_t offset = 0) const {
+    Source &current = sink.source(slot);
+    const bool first = current <= Source::default_value;
+    if (first) {
+      sink.touch(slot);
+    }
+#if INCANTI_STATS
+    const std::uint64_t start = Detail::now_ns();
+    const bool stored = args_[slot]->store(
+        sink.value(slot), value, first, {source, argv_index, offset}, error);
+    sink.converted(slot, Detail::now_ns() - start);
+    if (!stored) {
+      return false;
+    }
+#else
+    if (!args_[slot]->store(sink.value(slot), value, first,
+                            {source, argv_index, offset}, error)) {
+      return false;
+    }
+#endif
+    current = source;
+    return true;
+  }
+
+  /* the name lookups of a scan_tokens() target */
+  struct Lookup_ {
+    const Schema &s;
+
+    std::uint32_t find_long(std::string_view name) const {
+      Detail::count_lookup();
+      return s.index_.find(OptionIndex::Kind::long_name, name);
+    }
+    std::uint32_t find_short(std::string_view name) const {
+      Detail::count_lookup();
+      return s.shorts_.find(name);
+    }
+    std::uint32_t short_prefix(std::string_view token, size_t &length) const {
+      Detail::count_lookup();
+      return s.shorts_.longest_prefix(token, length);
+    }
+    std::uint32_t find_char(char c) const {
+      Detail::count_lookup();
+      return s.shorts_.find_char(c);
+    }
+    bool is_flag(std::uint32_t slot) const { return s.args_[slot]->is_flag(); }
+    std::string_view name(std::uint32_t slot) const {
+      return s.args_[slot]->name();
+    }
+    void suggest(Detail::NearMatches &near) const { s.near_options_(near); }
+  };
+
+  /* adapter giving scan_tokens() the schema's indexes and a sink */
+  template <typename Sink> struct Target_ : Lookup_ {
+    Sink &sink;
+
+    bool apply(std::uint32_t slot, std::string_view value,
+               const Detail::Origin &at, Error &error) {
+      return s.store_(sink, slot, value, at.source, error, at.argv_index,
+                      at.offset);
+    }
+    bool positional(std::string_view token, Error &error) {
+      return sink.positional(token, error);
+    }
+    void help() { sink.help(); }
+  };
+
+  /* one pass over the environment, each NAME=VALUE entry is looked up in
+   * the hashed index of bound names and parsed from its view in place */
+  template <typename Sink>
+  bool apply_environment_(Sink &sink, Error &error) const {
+    size_t pending{0};
+    for (std::uint32_t slot : env_slots_) {
+      pending += sink.source(slot) < Source::environment;
+    }
+    if (pending == 0) {
+      return true;
+    }
+
+    auto env_of = [this](std::uint32_t s) { return args_[s]->env_name(); };
+    char **envp = environment_ ? environment_ : INCANTI_ENVIRON;
+    for (; envp && *envp && pending > 0; ++envp) {
+      const char *entry = *envp;
+      const auto first = static_cast<unsigned char>(entry[0]);
+      if (!(env_first_[first >> 6] >> (first & 63) & 1)) {
+        continue;
+      }
+      const char *eq = std::strchr(entry, '=');
+      if (!eq) {
+        continue;
+      }
+      std::string_view env_name(entry, static_cast<size_t>(eq - entry));
+      std::uint32_t slot = env_names_.find(env_name, env_of);
+      if (slot == Detail::SlotTable::npos) {
+        continue;
+      }
+      if (sink.source(slot) >= Source::environment) {
+        continue; // set on the command line, or a repeated entry
+      }
+      if (!store_(sink, slot, eq + 1, Source::environment, error)) {
+        error.message = "Environment variable " + std::string(env_name) +
+                        ": " + error.message;
+        error.offset = 0;
+        return false;
+      }
+      --pending;
+    }
+    return true;
+  }
+
+  /* streams a mapped config file straight into the sink; the mapping stays
+   * alive until the next parse like response files */
+  template <typename Sink>
+  bool apply_config_(Sink &sink, const std::string &path,
+                     Error &error) const {
+    sink.mapped().emplace_back();
+    Detail::MappedFile &file = sink.mapped().back();
+    if (!Detail::MappedFile::open(path, file, error.message)) {
+      sink.mapped().pop_back();
+      error.code = ErrorCode::file_error;
+      return false;
+    }
+
+    Detail::ConfigLists lists;
+    auto on_entry = [&](const Detail::ConfigEntry &entry) {
+      const std::uint32_t slot = config_slot_(entry, path, error);
+      if (slot == OptionIndex::npos) {
+        return false;
+      }
+      if (sink.source(slot) > Source::config) {
+        return true; // set on the command line or from the environment
+      }
+      const bool replace = args_[slot]->is_list() && lists.first(slot) &&
+                           sink.source(slot) == Source::config;
+      return store_config_(sink, slot, entry, path, error, replace);
+    };
+    return Detail::scan_config(file.data(), file.size(), path, error,
+                               on_entry);
+  }
+
+  /* error about a config entry, placed at path:line:column */
+  static bool config_error_(Error &error, ErrorCode code,
+                            const Detail::ConfigEntry &entry,
+                            const std::string &path, size_t column,
+                            std::string message) {
+    error.code = code;
+    error.offset = 0;
+    error.option = std::string(entry.key);
+    error.message = path + ":" + std::to_string(entry.line) + ":" +
+                    std::to_string(column) + ": " + message;
+    return false;
+  }
+
+  /* the option a config key names, npos with the error filled in */
+  std::uint32_t config_slot_(const Detail::ConfigEntry &entry,
+                             const std::string &path, Error &error) const {
+    std::uint32_t slot = index_.find(OptionIndex::Kind::long_name, entry.key);
+    if (slot == OptionIndex::npos) {
+      config_error_(error, ErrorCode::unknown_option, entry, path,
+                    entry.key_column,
+                    "Unknown option '" + std::string(entry.key) + "'");
+      Detail::NearMatches near(entry.key);
+      near_options_(near, true);
+      near.report(error);
+    }
+    return slot;
+  }
+
+  /* one config entry into the sink: a value, an array element of a list,
+   * or true / false for a flag. replace starts a list set by an earlier
+   * file over */
+  template <typename Sink>
+  bool store_config_(Sink &sink, std::uint32_t slot,
+                     const Detail::ConfigEntry &entry,
+                     const std::string &path, Error &error,
+                     bool replace) const {
+    const Argument *arg = args_[slot];
+    if (entry.element && !arg->is_list()) {
+      return config_error_(error, ErrorCode::invalid_value, entry, path,
+                           entry.column,
+                           "'" + std::string(entry.key) +
+                               "' takes a single value, not an array");
+    }
+    if (replace) {
+      sink.source(slot) = Source::default_value;
+    }
+    if (!arg->is_flag()) {
+      if (!store_(sink, slot, entry.value, Source::config, error)) {
+        return config_error_(error, error.code, entry, path, entry.column,
+                             std::move(error.message));
+      }
+      return true;
+    }
+    bool on{false};
+    if (!Detail::boolify(entry.value, on)) {
+      return config_error_(error, ErrorCode::invalid_value, entry, path,
+                           entry.column,
+                           "Invalid boolean value: " +
+                               std::string(entry.value));
+    }
+    return !on || store_(sink, slot, {}, Source::config, error);
+  }
+
+  /* tokens are views over argv or a response file, nothing is copied
+   * unless a value type needs to own it */
+  template <typename Sink>
+  bool run_(TokenStream &tokens, Sink &sink, Error &error) const {
+    Target_<Sink> target{{*this}, sink};
+    return Detail::scan_tokens(tokens, target, error) &&
+           finish_(sink, error);
+  }
+
+  /* what follows the command line: environment, config files, then the
+   * check for required options */
+  template <typename Sink> bool finish_(Sink &sink, Error &error) const {
+    if (!apply_environment_(sink, error)) {
+      return false;
+    }
+    for (const std::string &path : config_paths_) {
+      if (!apply_config_(sink, path, error)) {
+        return false;
+      }
+    }
+    for (size_t i{0}; i < config_path_ptrs_.size(); ++i) {
+      const std::uint32_t bound = config_path_slots_[i];
+      const std::string &path =
+          bound == Detail::no_slot
+              ? *config_path_ptrs_[i]
+              : *static_cast<const std::string *>(sink.value(bound));
+      if (!path.empty() && !apply_config_(sink, path, error)) {
+        return false;
+      }
+    }
+
+    for (std::uint32_t slot : required_slots_) {
+      if (sink.source(slot) == Source::none) {
+        error.code = ErrorCode::missing_required;
+        error.option = args_[slot]->get_name();
+        error.message = "Required argument missing: --" + error.option;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <typename Run>
+  Expected<void> parse_into_(ParseResult &result, Run &&make_tokens) const;
+};
+
+/*
+ * The values of one Schema::parse(): typed storage for every option laid
+ * out in a single block, where each value came from, and the positionals.
+ * Positionals are views into argv, the result's own copy of a command line
+ * string or a response file it keeps mapped.
+ */
+class ParseResult {
+public:
+  /* every option at its default */
+  explicit ParseResult(std::shared_ptr<const Schema> schema)
+      : schema_(std::move(schema)) {
+    const Schema &s = *schema_;
+    // the values, then one Source per option
+    storage_ = allocate_(s.storage_size_ + s.args_.size(), s.storage_align_);
+    sources_ = reinterpret_cast<Source *>(storage_ + s.storage_size_);
+    for (std::uint32_t slot{0}; slot < s.args_.size(); ++slot) {
+      s.args_[slot]->construct(storage_ + s.offsets_[slot]);
+      sources_[slot] = s.args_[slot]->initial_source();
+    }
+  }
+
+  ParseResult(ParseResult &&other) noexcept
+      : schema_(std::move(other.schema_)),
+        storage_(std::exchange(other.storage_, nullptr)),
+        sources_(other.sources_),
+        positionals_(std::move(other.positionals_)),
+        command_buffer_(std::move(other.command_buffer_)),
+        mapped_(std::move(other.mapped_)), help_(other.help_) {}
+
+  ParseResult &operator=(ParseResult &&other) noexcept {
+    if (this != &other) {
+      release_();
+      schema_ = std::move(other.schema_);
+      storage_ = std::exchange(other.storage_, nullptr);
+      sources_ = other.sources_;
+      positionals_ = std::move(other.positionals_);
+      command_buffer_ = std::move(other.command_buffer_);
+      mapped_ = std::move(other.mapped_);
+      help_ = other.help_;
+    }
+    return *this;
+  }
+
+  ParseResult(const ParseResult &) = delete;
+  ParseResult &operator=(const ParseResult &) = delete;
+
+  ~ParseResult() { release_(); }
+
+  /* the value of an option, T must be the registered type */
+  template <typename T> const T &get(std::string_view name) const {
+    return get<T>(slot_(name));
+  }
+
+  template <typename T> const T &get(std::uint32_t slot) const {
+    const Argument &arg = schema_->argument(slot);
+    if (!arg.holds<T>()) {
+      Detail::raise(ParseError("Argument --" + arg.get_name() + " is not a " +
+                               type_name<T>()));
+    }
+    return *static_cast<const T *>(value_(slot));
+  }
+
+  /* given on the command line, in the environment or a config file */
+  bool was_set(std::string_view name) const { return was_set(slot_(name)); }
+  bool was_set(std::uint32_t slot) const {
+    return sources_[slot] > Source::default_value;
+  }
+
+  Source source(std::string_view name) const { return sources_[slot_(name)]; }
+  Source source(std::uint32_t slot) const { return sources_[slot]; }
+
+  const std::vector<std::string_view> &positional() const {
+    return positionals_;
+  }
+
+  /* -h / --help was given; a result never prints or exits */
+  bool help_requested() const { return help_; }
+
+  const Schema &schema() const { return *schema_; }
+
+private:
+  std::shared_ptr<const Schema> schema_;
+  unsigned char *storage_ = nullptr;
+  Source *sources_ = nullptr; // in storage_
+  std::vector<std::string_view> positionals_;
+  // not a std::string: views must survive moving the result
+  std::vector<char> command_buffer_;
+  std::vector<Detail::MappedFile> mapped_;
+  bool help_ = false;
+
+  friend class Schema;
+  friend class ConfigWatcher;
+
+  static bool over_aligned_(size_t align) {
+    return align > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+  }
+
+  static unsigned char *allocate_(size_t size, size_t align) {
+    size = std::max<size_t>(size, 1);
+    void *p = over_aligned_(align)
+                  ? ::operator new(size, std::align_val_t{align})
+                  : ::operator new(size);
+    return static_cast<unsigned char *>(p);
+  }
+
+  void release_() {
+    if (!storage_) {
+      return;
+    }
+    const Schema &s = *schema_;
+    for (std::uint32_t slot{0}; slot < s.args_.size(); ++slot) {
+      s.args_[slot]->destroy_value(storage_ + s.offsets_[slot]);
+    }
+    if (over_aligned_(s.storage_align_)) {
+      ::operator delete(storage_, std::align_val_t{s.storage_align_});
+    } else {
+      ::operator delete(storage_);
+    }
+    storage_ = nullptr;
+  }
+
+  std::uint32_t slot_(std::string_view name) const {
+    std::uint32_t slot = schema_->slot(name);
+    if (slot == Schema::npos) {
+      Detail::raise(ParseError("Unknown argument: --" + std::string(name)));
+    }
+    return slot;
+  }
+
+  void *value_(std::uint32_t slot) const {
+    return storage_ + schema_->offsets_[slot];
+  }
+
+  /* the Schema's view of a result */
+  struct Sink_ {
+    ParseResult &r;
+
+    Source &source(std::uint32_t slot) { return r.sources_[slot]; }
+    void *value(std::uint32_t slot) { return r.value_(slot); }
+    void touch(std::uint32_t) {}
+    std::vector<Detail::MappedFile> &mapped() { return r.mapped_; }
+    bool positional(std::string_view token, Error &) {
+      r.positionals_.push_back(token);
+      return true;
+    }
+    void help() { r.help_ = true; }
+    void converted(std::uint32_t, std::uint64_t) {}
+  };
+
+  /* back to the defaults, only the slots the last parse changed */
+  void restart_() {
+    const Schema &s = *schema_;
+    for (std::uint32_t slot{0}; slot < s.args_.size(); ++slot) {
+      if (sources_[slot] > Source::default_value) {
+        s.args_[slot]->restart(value_(slot));
+        sources_[slot] = s.args_[slot]->initial_source();
+      }
+    }
+    positionals_.clear();
+    // views from the previous parse may point into these
+    mapped_.clear();
+    help_ = false;
+  }
+};
+
+template <typename Run>
+Expected<void> Schema::parse_into_(ParseResult &result,
+                                   Run &&make_tokens) const {
+  if (result.schema_.get() != this) {
+    Detail::raise(ParseError("ParseResult belongs to another schema"));
+  }
+  result.restart_();
+  TokenStream tokens = make_tokens(result);
+  ParseResult::Sink_ sink{result};
+  Error error;
+  if (!run_(tokens, sink, error)) {
+    return Unexpected{std::move(error)};
+  }
+  return {};
+}
+
+inline Expected<void> Schema::try_parse(int argc, char *argv[],
+                                        ParseResult &result) const {
+  return parse_into_(result, [&](ParseResult &r) {
+    return TokenStream(argc, argv, response_files_ ? &r.mapped_ : nullptr,
+                       response_depth_);
+  });
+}
+
+inline Expected<void> Schema::try_parse(std::string_view command_line,
+                                        ParseResult &result) const {
+  return parse_into_(result, [&](ParseResult &r) {
+    r.command_buffer_.assign(command_line.begin(), command_line.end());
+    char *begin = r.command_buffer_.data();
+    return TokenStream(begin, begin + r.command_buffer_.size(),
+                       response_files_ ? &r.mapped_ : nullptr,
+                       response_depth_);
+  });
+}
+
+inline Expected<ParseResult> Schema::try_parse(int argc, char *argv[]) const {
+  ParseResult result(shared_from_this());
+  Expected<void> parsed = try_parse(argc, argv, result);
+  if (!parsed) {
+    return Unexpected{std::move(parsed.error())};
+  }
+  return result;
+}
+
+inline Expected<ParseResult>
+Schema::try_parse(std::string_view command_line) const {
+  ParseResult result(shared_from_this());
+  Expected<void> parsed = try_parse(command_line, result);
+  if (!parsed) {
+    return Unexpected{std::move(parsed.error())};
+  }
+  return result;
+}
+
+inline void Schema::parse(int argc, char *argv[], ParseResult &result) const {
+  Expected<void> parsed = try_parse(argc, argv, result);
+  if (!parsed) {
+    Detail::raise(ParseError(std::move(parsed.error())));
+  }
+}
+
+inline void Schema::parse(std::string_view command_line,
+                          ParseResult &result) const {
+  Expected<void> parsed = try_parse(command_line, result);
+  if (!parsed) {
+    Detail::raise(ParseError(std::move(parsed.error())));
+  }
+}
+
+/* one item of Schema::parse_batch() */
+struct BatchResult {
+  std::optional<ParseResult> result; // when the item parsed
+  std::optional<Error> error;        // when it did not
+
+  bool ok() const { return result.has_value(); }
+};
+
+template <typename Items>
+std::vector<BatchResult> Schema::parse_batch(const Items &items,
+                                             WorkerPool &pool) const {
+  std::shared_ptr<const Schema> self = shared_from_this();
+  auto first = std::begin(items);
+  std::vector<BatchResult> results(
+      static_cast<size_t>(std::distance(first, std::end(items))));
+  pool.run(results.size(), [&](size_t i) {
+    using Item = std::decay_t<decltype(first[i])>;
+    const Item &item = first[i];
+    BatchResult &out = results[i];
+    ParseResult &result = out.result.emplace(self);
+    Expected<void> parsed;
+    if constexpr (std::is_convertible_v<const Item &, std::string_view>) {
+      parsed = try_parse(std::string_view(item), result);
+    } else {
+      auto *argv = const_cast<char **>(
+          static_cast<const char *const *>(std::data(item)));
+      auto argc = static_cast<int>(std::size(item));
+      if (argc > 0 && argv[argc - 1] == nullptr) {
+        --argc; // a terminated argv
+      }
+      parsed = try_parse(argc, argv, result);
+    }
+    if (!parsed) {
+      out.result.reset();
+      out.error.emplace(std::move(parsed.error()));
+    }
+  });
+  return results;
+}
+
+inline ParseResult Schema::parse(int argc, char *argv[]) const {
+  return std::move(try_parse(argc, argv).value());
+}
+
+inline ParseResult Schema::parse(std::string_view command_line) const {
+  return std::move(try_parse(command_line).value());
+}
+
+inline size_t Schema::complete(int count, char *words[],
+                              std::string &out) const {
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (!sealed_ || completion_dirty_) {
+      build_completion_();
+    }
+  }
+
+  std::string_view current = count > 0 ? words[count - 1] : "";
+  std::string_view previous = count > 1 ? words[count - 2] : "";
+  size_t found{0};
+  auto emit = [&](std::string_view head, std::string_view tail) {
+    out.append(head).append(tail).append(1, '\n');
+    ++found;
+  };
+  auto values = [&](std::uint32_t slot, std::string_view prefix,
+                    std::string_view head) {
+    if (slot != Detail::no_slot) {
+      completion_.values(slot, prefix,
+                         [&](std::string_view value) { emit(head, value); });
+    }
+    return found;
+  };
+
+  // --name=value as one word (zsh, fish)
+  if (current.size() > 2 && current[0] == '-' && current[1] == '-') {
+    size_t eq = current.find('=');
+    if (eq != std::string_view::npos) {
+      return values(value_option_(current.substr(0, eq)),
+                    current.substr(eq + 1), current.substr(0, eq + 1));
+    }
+  }
+  // bash splits it into --name, = and value
+  if (current == "=") {
+    return values(value_option_(previous), {}, {});
+  }
+  if (previous == "=" && count > 2) {
+    return values(value_option_(words[count - 3]), current, {});
+  }
+
+  std::uint32_t slot = value_option_(previous);
+  if (slot != Detail::no_slot) {
+    return values(slot, current, {});
+  }
+  if (!current.empty() && current[0] == '-') {
+    completion_.options(current, [&](std::string_view spelling,
+                                     std::uint32_t) { emit(spelling, {}); });
+  } else if (!commands_.empty()) {
+    // the verb, indexed without dashes or a slot
+    completion_.options(current,
+                        [&](std::string_view spelling, std::uint32_t slot) {
+                          if (slot == Detail::no_slot) {
+                            emit(spelling, {});
+                          }
+                        });
+  }
+  return found;
+}
+
+inline std::string Schema::completion_script(Shell shell,
+                                             std::string_view program) const {
+  if (program.empty()) {
+    program = program_name_;
+  }
+  // the command as typed, and a function name derived from it
+  size_t slash = program.find_last_of("/\\");
+  std::string name(slash == std::string_view::npos ? program
+                                                   : program.substr(slash + 1));
+  std::string function = "_incanti_";
+  for (char c : name) {
+    const bool word = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                      (c >= '0' && c <= '9');
+    function += word ? c : '_';
+  }
+
+  std::string script;
+  switch (shell) {
+  case Shell::bash:
+    script = "# bash completion for " + name + "\n" + function +
+             "() {\n"
+             "    local IFS=$'\\n'\n"
+             "    COMPREPLY=($(\"${COMP_WORDS[0]}\" __complete "
+             "\"${COMP_WORDS[@]:1:COMP_CWORD}\" 2>/dev/null))\n"
+             "}\n"
+             "complete -o default -F " +
+             function + " " + name + "\n";
+    break;
+  case Shell::zsh:
+    script = "#compdef " + name + "\n# zsh completion for " + name + "\n" +
+             function +
+             "() {\n"
+             "    local -a candidates\n"
+             "    candidates=(${(f)\"$(${words[1]} __complete "
+             "\"${(@)words[2,CURRENT]}\" 2>/dev/null)\"})\n"
+             "    if (( ${#candidates} )); then\n"
+             "        compadd -Q -- $candidates\n"
+             "    else\n"
+             "        _files\n"
+             "    fi\n"
+             "}\n"
+             "compdef " +
+             function + " " + name + "\n";
+    break;
+  case Shell::fish:
+    script = "# fish completion for " + name + "\nfunction " + function +
+             "\n"
+             "    set -l words (commandline -opc)\n"
+             "    set -l current (commandline -ct)\n"
+             "    $words[1] __complete $words[2..-1] \"$current\" "
+             "2>/dev/null\n"
+             "end\n"
+             "complete -c " +
+             name + " -a '(" + function + ")'\n";
+    break;
+  }
+  return script;
+}
+
+/*
+ * Binds options to variables. Registration goes into a Schema the parser
+ * owns, and parse() runs that schema with the bound variables as the
+ * destination of every value.
+ */
+class Parser {
+public:
+  Parser(const std::string &program_name = "",
+         const std::string &program_desc = "")
+      : schema_(new Schema(program_name, program_desc)),
+        program_name_(program_name), help_added_(false) {
+    add_help_flag();
+  }
+
+  Parser(const Parser &) = delete;
+  Parser &operator=(const Parser &) = delete;
+
+  template <typename T>
+  TypedArgument<T> &arg(std::string_view name, std::string_view short_name,
+                        T *value_ptr) {
+    return schema_->add_arg_<TypedArgument<T>>(name, short_name, value_ptr);
+  }
+
+  template <typename T>
+  TypedArgument<T> &arg(std::string_view name, T *value_ptr) {
+    return arg(name, "", value_ptr);
+  }
+
+  /* add args which are flags - true/false */
+  FlagArgument &flag(std::string_view name, std::string_view short_name,
+                     bool *value_ptr) {
+    return schema_->add_arg_<FlagArgument>(name, short_name, value_ptr);
+  }
+
+  /* add args which are flags - true/false (when no short name) */
+  FlagArgument &flag(std::string_view name, bool *value_ptr) {
+    return flag(name, "", value_ptr);
+  }
+
+  /*
+   * A git style subcommand: `prog [options] name [options] [args]`. setup
+   * registers its options on a Parser of its own and runs only once name
+   * is the verb given, so start up follows the verb used rather than the
+   * whole tool. Options of this parser stay valid after the verb, and a
+   * subcommand can have subcommands of its own.
+   */
+  template <typename Setup>
+  void command(std::string_view name, std::string_view description,
+               Setup &&setup) {
+    check_unshared_("commands");
+#if INCANTI_STATS
+    const std::uint64_t start = Detail::now_ns();
+#endif
+    Schema &s = *schema_;
+    if (s.sealed_) {
+      Detail::raise(ParseError("Cannot register command " +
+                               std::string(name) +
+                               ": parser schema is sealed"));
+    }
+    if (name.empty() || name[0] == '-' ||
+        command_index_(name) != Detail::SlotTable::npos) {
+      Detail::raise(
+          ParseError("Invalid or duplicate command name: " +
+                     std::string(name)));
+    }
+    auto index = static_cast<std::uint32_t>(s.commands_.size());
+    s.commands_.push_back({s.arena_.intern(name),
+                           s.arena_.intern(description),
+                           std::forward<Setup>(setup)});
+    s.command_names_.insert(index, s.commands_.back().name,
+                            [&s](std::uint32_t i) {
+                              return s.commands_[i].name;
+                            });
+    s.completion_dirty_ = true;
+    s.trees_dirty_ = true;
+#if INCANTI_STATS
+    ++s.registrations_;
+    s.registration_ns_ += Detail::now_ns() - start;
+#endif
+  }
+
+  MemoryUsage memory_usage() const { return schema_->memory_usage_(); }
+
+  /*
+   * Freeze the schema: builds the flat name index once, after which no more
+   * arguments can be registered. Unsealed parsers build the same index
+   * lazily on parse(). Arguments have to be marked required before that.
+   */
+  void seal() {
+    schema_->build_index_();
+    schema_->sealed_ = true;
+  }
+
+  bool sealed() const { return schema_->sealed_; }
+
+  /*
+   * Seal and hand out the schema for Schema::parse(), which threads can
+   * call concurrently. The schema stays valid after the parser is gone;
+   * its settings (response files, config files, environment) are frozen.
+   */
+  std::shared_ptr<const Schema> share() {
+    if (!schema_->commands_.empty()) {
+      Detail::raise(ParseError("Cannot share a parser with commands"));
+    }
+    seal();
+    shared_ = true;
+    return schema_;
+  }
+
+  const OptionIndex &index() {
+    schema_->build_index_();
+    return schema_->index_;
+  }
+
+  /*
+   * Expand `@file` arguments from response files (off by default). Files may
+   * reference further files up to max_depth levels.
+   */
+  void response_files(bool enable = true, size_t max_depth = 8) {
+    check_unshared_("response files");
+    schema_->response_files_ = enable;
+    schema_->response_depth_ = max_depth;
+  }
+
+  /*
+   * `key = value` files layered under the command line and the environment
+   * (command line > environment > config > default), read in the order
+   * given. Keys are long option names; see scan_config() for the syntax.
+   */
+  void config_file(std::string path) {
+    check_unshared_("config files");
+    schema_->config_paths_.push_back(std::move(path));
+  }
+
+  /* a file named by a bound string, read after the command line has been
+   * scanned so the path can come from an option; empty means none */
+  void config_file(const std::string *path) {
+    check_unshared_("config files");
+    schema_->config_path_ptrs_.push_back(path);
+    schema_->index_dirty_ = true;
+  }
+
+  /* NAME=VALUE block read for .env() bindings, the process environment
+   * when null (main's envp can be passed here) */
+  void environment(char **envp) {
+    check_unshared_("the environment");
+    schema_->environment_ = envp;
+  }
+
+  /* -h / --help prints the help and exits, see help_requested() for the
+   * other entry points */
+  void parse(int argc, char *argv[]) {
+    exit_on_help_ = true;
+    Expected<void> parsed = try_parse(argc, argv);
+    exit_on_help_ = false;
+    if (!parsed) {
+      Detail::raise(ParseError(std::move(parsed.error())));
+    }
+  }
+
+  /* parse() without exceptions; on failure the bound variables hold what
+   * was parsed before the error */
+  Expected<void> try_parse(int argc, char *argv[]) {
+    if (argc > 1 && schema_->complete_mode_ &&
+        std::strcmp(argv[1], "__complete") == 0) {
+      complete_and_exit_(argc - 2, argv + 2);
+    }
+    if (argc > 0 && program_name_.empty()) {
+      program_name_ = argv[0];
+    }
+    return measured_([&]() -> Expected<void> {
+      begin_parse_();
+      if (!schema_->commands_.empty()) {
+        return run_level_(argc, argv, 0);
+      }
+      TokenStream tokens(argc, argv,
+                         schema_->response_files_ ? &mapped_ : nullptr,
+                         schema_->response_depth_);
+      return run_(tokens);
+    });
+  }
+
+  /*
+   * Parse the arguments in a string (no program name), split like a POSIX
+   * shell does: '...' is literal, "..." and bare words take backslash
+   * escapes. The string is copied once into a buffer the parser keeps and
+   * tokenized there in place, so a warm parser does not allocate.
+   */
+  void parse(std::string_view command_line) {
+    Expected<void> parsed = try_parse(command_line);
+    if (!parsed) {
+      Detail::raise(ParseError(std::move(parsed.error())));
+    }
+  }
+
+  Expected<void> try_parse(std::string_view command_line) {
+    return measured_([&]() -> Expected<void> {
+      command_buffer_.assign(command_line.data(), command_line.size());
+      begin_parse_();
+      char *begin = command_buffer_.data();
+      if (!schema_->commands_.empty()) {
+        // the verb is found by position, so the words are split up front
+        TokenStream words(begin, begin + command_buffer_.size(), nullptr, 0);
+        command_words_.clear();
+        std::string_view word;
+        while (words.next(word)) {
+          command_words_.emplace_back(word);
+        }
+        if (words.failed()) {
+          return Unexpected{std::move(words.error())};
+        }
+        command_argv_.assign(1, program_name_.data());
+        for (std::string &w : command_words_) {
+          command_argv_.push_back(w.data());
+        }
+        return run_level_(static_cast<int>(command_argv_.size()),
+                          command_argv_.data(), 0);
+      }
+      TokenStream tokens(begin, begin + command_buffer_.size(),
+                         schema_->response_files_ ? &mapped_ : nullptr,
+                         schema_->response_depth_);
+      return run_(tokens);
+    });
+  }
+
+  /*
+   * Forget the last parse: every argument a parse has set goes back to its
+   * default (0, false or empty without def()), positionals are dropped and
+   * response or config file mappings released. Capacity is kept, nothing
+   * is allocated.
+   */
+  void reset() {
+    for (Argument *arg : schema_->args_) {
+      arg->restart();
+    }
+    touched_.clear();
+    positionals_.clear();
+    positional_strings_stale_ = true;
+    mapped_.clear();
+    if (selected_) {
+      selected_->reset();
+    }
+    selected_name_ = {};
+    help_requested_ = false;
+  }
+
+  /* positional tokens as strings, built on first use after a parse */
+  const std::vector<std::string> &positional() const {
+    if (positional_strings_stale_) {
+      positional_strings_.assign(positionals_.begin(), positionals_.end());
+      positional_strings_stale_ = false;
+    }
+    return positional_strings_;
+  }
+
+  /* positional tokens as views into argv, the command line buffer or a
+   * response file; valid until the next parse() or reset() */
+  const std::vector<std::string_view> &positional_views() const {
+    return positionals_;
+  }
+
+  /*
+   * Hand each positional to callback(std::string_view) as it is scanned
+   * instead of collecting it: memory stays flat however many there are
+   * and work can start on the first one. positional() then stays empty.
+   * Options given before a positional are set when it is handed over;
+   * later ones, the environment and config files are not yet. The view
+   * lasts for the call (a token from argv as long as argv). An empty
+   * callback goes back to collecting.
+   */
+  template <typename Callback> void on_positional(Callback &&callback) {
+    on_positional_ = std::forward<Callback>(callback);
+  }
+
+  /*
+   * With on_positional(), a "-" positional reads entries ended by
+   * separator from standard input, as `find -print0` and `xargs -0` write
+   * them, and hands over each in turn; read in blocks, so memory stays
+   * flat.
+   */
+  void positional_stdin(bool enable = true, char separator = '\0') {
+    positional_stdin_ = enable;
+    stdin_separator_ = separator;
+  }
+
+  /*
+   * Registration and parse costs of this parser: time in arg(), flag(),
+   * command() and index builds, then per parse the time, tokens, index
+   * lookups and heap allocations (see note_allocation()), and per option
+   * the values stored and the time their conversion took. Collected in
+   * builds with INCANTI_STATS=1 only, all zero otherwise. A subcommand
+   * keeps its own; the parse of the parser it belongs to includes it.
+   */
+  Stats stats() const {
+    Stats stats;
+#if INCANTI_STATS
+    stats = stats_;
+    stats.registrations = schema_->registrations_;
+    stats.registration_ns = schema_->registration_ns_;
+    stats.options.resize(schema_->args_.size());
+    for (size_t i{0}; i < stats.options.size(); ++i) {
+      stats.options[i].name = schema_->args_[i]->get_name();
+    }
+#endif
+    return stats;
+  }
+
+  void reset_stats() {
+#if INCANTI_STATS
+    stats_ = {};
+    schema_->registrations_ = 0;
+    schema_->registration_ns_ = 0;
+#endif
+  }
+
+  /* -h / --help was in the last try_parse() or parse(command_line), on
+   * this parser or a subcommand; the help is not printed */
+  bool help_requested() const { return help_requested_; }
+
+  /* the verb of the last parse, empty when none was given */
+  std::string_view selected_command() const { return selected_name_; }
+
+  /* the parser of that subcommand, with its options and positionals;
+   * null when no verb was given */
+  Parser *selected_parser() {
+    return selected_name_.empty() ? nullptr : selected_.get();
+  }
+
+  void print_help(std::ostream &out = std::cout) {
+    schema_->print_help_(program_name_, out);
+  }
+
+  /* see Schema::help() */
+  std::string_view help(size_t width = 0) const {
+    return schema_->help_(program_name_, width);
+  }
+
+  /*
+   * Let `prog __complete words...` answer a completion query (see
+   * Schema::complete()) and exit from parse(), before anything else is
+   * read; call parse() ahead of expensive start up work. Off by default,
+   * and needed by the scripts completion_script() writes.
+   */
+  void completion(bool enable = true) {
+    check_unshared_("completion");
+    schema_->complete_mode_ = enable;
+  }
+
+  size_t complete(int count, char *words[], std::string &out) {
+    schema_->build_index_();
+    if (!schema_->commands_.empty()) {
+      // words after a verb complete against that subcommand
+      const int verb = find_verb_(0, count - 1, words);
+      const std::uint32_t index =
+          verb < count - 1 ? command_index_(words[verb])
+                           : Detail::SlotTable::npos;
+      if (index != Detail::SlotTable::npos) {
+        return materialize_(index).complete(count - verb - 1,
+                                            words + verb + 1, out);
+      }
+    }
+    return schema_->complete(count, words, out);
+  }
+
+  /* see Schema::completion_script() */
+  std::string completion_script(Shell shell) const {
+    return schema_->completion_script(shell, program_name_);
+  }
+
+private:
+  friend class ConfigWatcher;
+
+  std::shared_ptr<Schema> schema_;
+  std::string program_name_;
+  std::vector<std::string_view> positionals_;
+  mutable std::vector<std::string> positional_strings_;
+  mutable bool positional_strings_stale_ = false;
+  std::string command_buffer_;
+  bool help_added_;
+  bool help_value_ = false;
+  bool help_requested_ = false;
+  bool exit_on_help_ = false;
+  bool shared_ = false;
+
+  // response and config files mapped by the last parse
+  std::vector<Detail::MappedFile> mapped_;
+  // on_positional(), and the block standard input is read through
+  std::function<void(std::string_view)> on_positional_;
+  bool positional_stdin_ = false;
+  char stdin_separator_ = '\0';
+  std::vector<char> stdin_buffer_;
+  // slots whose source the last parse changed
+  std::vector<std::uint32_t> touched_;
+
+  // the parser this one is a subcommand of, and the subcommand built for
+  // the last verb (kept while the same verb comes back)
+  Parser *parent_ = nullptr;
+  std::unique_ptr<Parser> selected_;
+  std::uint32_t selected_index_ = Detail::SlotTable::npos;
+  std::string_view selected_name_;
+  // a command line string split into words for commands
+  std::vector<std::string> command_words_;
+  std::vector<char *> command_argv_;
+
+#if INCANTI_STATS
+  Stats stats_;
+#endif
+
+  void check_unshared_(const char *what) const {
+    if (shared_) {
+      Detail::raise(ParseError(std::string("Cannot change ") + what +
+                               ": parser schema is shared"));
+    }
+  }
+
+  [[noreturn]] void complete_and_exit_(int count, char *words[]) {
+    std::string out;
+    complete(count, words, out);
+    Detail::write_stdout(out);
+    std::exit(0);
+  }
+
+  /* a positional token, collected or handed to on_positional() */
+  bool positional_(std::string_view token, Error &error) {
+    if (!on_positional_) {
+      positionals_.push_back(token);
+      return true;
+    }
+    if (positional_stdin_ && token == "-") {
+      return Detail::read_stdin_entries(stdin_separator_, stdin_buffer_,
+                                        on_positional_, error);
+    }
+    on_positional_(token);
+    return true;
+  }
+
+  /* one parse, counted in stats() by INCANTI_STATS builds */
+  template <typename Run> Expected<void> measured_(Run &&run) {
+#if INCANTI_STATS
+    const Detail::ThreadCounters before = Detail::thread_counters;
+    const std::uint64_t start = Detail::now_ns();
+    Expected<void> parsed = run();
+    const Detail::ThreadCounters &after = Detail::thread_counters;
+    ++stats_.parses;
+    stats_.parse_ns += Detail::now_ns() - start;
+    stats_.tokens += after.tokens - before.tokens;
+    stats_.lookups += after.lookups - before.lookups;
+    stats_.allocations += after.allocations - before.allocations;
+    stats_.allocated_bytes += after.allocated_bytes - before.allocated_bytes;
+    return parsed;
+#else
+    return run();
+#endif
+  }
+
+  Expected<void> run_(TokenStream &tokens) {
+    Sink_ sink{*this};
+    Error error;
+    if (!schema_->run_(tokens, sink, error)) {
+      return Unexpected{std::move(error)};
+    }
+    return {};
+  }
+
+  std::uint32_t command_index_(std::string_view name) const {
+    const Schema &s = *schema_;
+    return s.command_names_.find(
+        name, [&s](std::uint32_t i) { return s.commands_[i].name; });
+  }
+
+  /* position of the verb in argv[first, argc): the first word that is not
+   * an option or the value of one, argc when there is none */
+  int find_verb_(int first, int argc, char *argv[]) {
+    Chain_ chain{*this, 0};
+    for (int i{first}; i < argc; ++i) {
+      std::string_view word = argv[i];
+      if (word.size() > 1 && word[0] == '@' && schema_->response_files_) {
+        continue; // options, as far as verbs go
+      }
+      if (word.size() < 2 || word[0] != '-') {
+        return i;
+      }
+      if (Schema::value_option_(chain, word) != Detail::no_slot) {
+        ++i;
+      }
+    }
+    return argc;
+  }
+
+  /* the subcommand's parser, its setup run the first time it is needed */
+  Parser &materialize_(std::uint32_t index) {
+    if (selected_ && selected_index_ == index) {
+      return *selected_;
+    }
+    const Schema &s = *schema_;
+    const Schema::Command_ &command = s.commands_[index];
+    selected_.reset();
+    selected_index_ = Detail::SlotTable::npos;
+    std::string program(command.name);
+    if (!program_name_.empty()) {
+      program = program_name_ + " " + program;
+    }
+    auto sub =
+        std::make_unique<Parser>(program, std::string(command.description));
+    sub->parent_ = this;
+    sub->schema_->parent_ = schema_.get();
+    sub->schema_->response_files_ = s.response_files_;
+    sub->schema_->response_depth_ = s.response_depth_;
+    sub->schema_->environment_ = s.environment_;
+    command.setup(*sub);
+    selected_ = std::move(sub);
+    selected_index_ = index;
+    return *selected_;
+  }
+
+  /*
+   * Parses argv for this parser and the subcommand a verb selects. argv[0]
+   * is the program or this parser's verb, base its position in the whole
+   * command line. The enclosing parsers finish (environment, config files,
+   * required options) after their subcommands, which may still set them.
+   */
+  Expected<void> run_level_(int argc, char *argv[], int base) {
+    Schema &s = *schema_;
+    const int verb = s.commands_.empty() ? argc : find_verb_(1, argc, argv);
+    TokenStream tokens(verb, argv, s.response_files_ ? &mapped_ : nullptr,
+                       s.response_depth_);
+    Chain_ chain{*this, base};
+    Sink_ sink{*this};
+    Error error;
+    if (Detail::scan_tokens(tokens, chain, error)) {
+      if (verb < argc) {
+        const std::uint32_t index = command_index_(argv[verb]);
+        if (index == Detail::SlotTable::npos) {
+          error.code = ErrorCode::unknown_command;
+          error.argv_index = base + verb;
+          error.option = argv[verb];
+          error.message = "Unknown command: " + error.option;
+          Detail::NearMatches near(error.option);
+          s.near_commands_(near);
+          near.report(error);
+          return Unexpected{std::move(error)};
+        }
+        Parser &sub = materialize_(index);
+        selected_name_ = s.commands_[index].name;
+        sub.begin_parse_();
+        Expected<void> parsed =
+            sub.run_level_(argc - verb, argv + verb, base + verb);
+        if (!parsed) {
+          return parsed;
+        }
+      }
+      if (s.finish_(sink, error)) {
+        return {};
+      }
+    }
+    if (error.argv_index > 0) {
+      error.argv_index += base;
+    }
+    return Unexpected{std::move(error)};
+  }
+
+  /* the bound variables as the schema's destination */
+  struct Sink_ {
+    Parser &p;
+
+    Source &source(std::uint32_t slot) {
+      return p.schema_->args_[slot]->source_;
+    }
+    void *value(std::uint32_t slot) { return p.schema_->args_[slot]->value_; }
+    void touch(std::uint32_t slot) {
+      p.schema_->args_[slot]->written_ = true;
+      p.touched_.push_back(slot);
+    }
+    std::vector<Detail::MappedFile> &mapped() { return p.mapped_; }
+    bool positional(std::string_view token, Error &error) {
+      return p.positional_(token, error);
+    }
+    void help() { p.help_(); }
+#if INCANTI_STATS
+    void converted(std::uint32_t slot, std::uint64_t ns) {
+      std::vector<OptionStats> &options = p.stats_.options;
+      if (options.size() <= slot) {
+        options.resize(slot + 1);
+      }
+      ++options[slot].conversions;
+      options[slot].convert_ns += ns;
+    }
+#endif
+  };
+
+  /*
+   * scan_tokens() target over this parser's options, then those of the
+   * parsers it is a subcommand of. A slot carries its level in the top
+   * byte, the parser's own options being level 0.
+   */
+  struct Chain_ {
+    Parser &p;
+    int base; // argv index of this parser's first token in the whole line
+    static constexpr unsigned shift = 24;
+
+    template <typename Find> std::uint32_t find_(Find &&find) const {
+      std::uint32_t level{0};
+      for (const Parser *q = &p; q; q = q->parent_, ++level) {
+        std::uint32_t slot = find(Schema::Lookup_{*q->schema_});
+        if (slot != Detail::no_slot) {
+          return level << shift | slot;
+        }
+      }
+      return Detail::no_slot;
+    }
+    Parser &level_(std::uint32_t slot) const {
+      Parser *q = &p;
+      for (std::uint32_t level = slot >> shift; level > 0; --level) {
+        q = q->parent_;
+      }
+      return *q;
+    }
+    static std::uint32_t local_(std::uint32_t slot) {
+      return slot & ((1u << shift) - 1);
+    }
+    const Argument &arg_(std::uint32_t slot) const {
+      return *level_(slot).schema_->args_[local_(slot)];
+    }
+
+    std::uint32_t find_long(std::string_view name) const {
+      return find_([&](const Schema::Lookup_ &l) { return l.find_long(name); });
+    }
+    std::uint32_t find_short(std::string_view name) const {
+      return find_(
+          [&](const Schema::Lookup_ &l) { return l.find_short(name); });
+    }
+    std::uint32_t short_prefix(std::string_view token, size_t &length) const {
+      return find_([&](const Schema::Lookup_ &l) {
+        return l.short_prefix(token, length);
+      });
+    }
+    std::uint32_t find_char(char c) const {
+      return find_([&](const Schema::Lookup_ &l) { return l.find_char(c); });
+    }
+    bool is_flag(std::uint32_t slot) const { return arg_(slot).is_flag(); }
+    std::string_view name(std::uint32_t slot) const {
+      return arg_(slot).name();
+    }
+    void suggest(Detail::NearMatches &near) const {
+      for (const Parser *q = &p; q; q = q->parent_) {
+        q->schema_->near_options_(near);
+      }
+    }
+    bool apply(std::uint32_t slot, std::string_view value,
+               const Detail::Origin &at, Error &error) {
+      Parser &q = level_(slot);
+      Sink_ sink{q};
+      return q.schema_->store_(sink, local_(slot), value, at.source, error,
+                               base + at.argv_index, at.offset);
+    }
+    bool positional(std::string_view token, Error &error) {
+      return p.positional_(token, error);
+    }
+    void help() { p.help_(); }
+  };
+
+  /* -h / --help on the current level; only parse(argc, argv) exits */
+  void help_() {
+    help_requested_ = true;
+    Parser *root = this;
+    while (root->parent_) {
+      root = root->parent_;
+      root->help_requested_ = true;
+    }
+    if (root->exit_on_help_) {
+      print_help();
+      exit(0);
+    }
   }
 
-  void parse(const std::string &value) override {
-    try {
-      *value_ptr_ = str_to_T_(value);
-      parsed_ = true;
-    } catch (const std::exception &e) {
-      throw ParseError("Failed to parse '" + value + "' for argument --" +
-                       name_ + ": " + e.what());
+  /* lists and environment bound arguments start over on every parse, all
+   * arguments do when config files are in use; see reset() for the rest */
+  void begin_parse_() {
+    Schema &s = *schema_;
+    s.build_index_();
+    for (std::uint32_t slot : touched_) {
+      s.args_[slot]->source_ = s.args_[slot]->initial_source();
+    }
+    touched_.clear();
+    if (!s.has_config_()) {
+      for (std::uint32_t slot : s.restart_slots_) {
+        s.args_[slot]->restart();
+      }
+    } else {
+      // any value may come from a file that changed since the last parse
+      for (Argument *arg : s.args_) {
+        arg->restart();
+      }
     }
+    positionals_.clear();
+    positional_strings_stale_ = true;
+    // views from the previous parse may point into these
+    mapped_.clear();
+    selected_name_ = {};
+    help_requested_ = false;
   }
-  bool has_value() const override { return parsed_ || has_default_; }
-  bool is_required() const override { return required_; }
-  std::string get_name() const override { return name_; }
 
-  std::string get_help() const override {
-    std::string result;
-    if (!short_name_.empty()) {
-      result += "-" + short_name_ + ", ";
+  void add_help_flag() {
+    if (!help_added_) {
+      flag("help", "h", &help_value_).help("Show this help message");
+      help_added_ = true;
     }
-    result += "--" + name_;
+  }
+};
 
-    if (!std::is_same_v<T, bool>) {
-      result += " <value>";
+/*
+ * Re-reads the config files of a parser when they change and publishes
+ * the options bound to a Reloadable, so a long running daemon can be
+ * tuned without a restart:
+ *
+ *   Incanti::Reloadable<int> threads{4};
+ *   parser >> arg("threads", &threads) | on_change(resize_pool);
+ *   parser.config_file("/etc/app.toml");
+ *   parser.parse(argc, argv);
+ *
+ *   Incanti::ConfigWatcher watcher(parser);
+ *   watcher.start();
+ *
+ * A reload scans the files again but converts only the reloadable
+ * options whose text changed. Once all of them have converted each is
+ * published in one atomic store, then the change callbacks run; a reload
+ * that fails (a syntax error, an unknown key, a rejected value) publishes
+ * nothing. Options set on the command line or from the environment keep
+ * that value, other options keep the value they started with, and a
+ * reloadable key removed from the files goes back to its default.
+ *
+ * Create the watcher after parse(). It seals the parser, which must not
+ * be parsed or reset again while the watcher lives.
+ */
+class ConfigWatcher {
+public:
+  explicit ConfigWatcher(Parser &parser)
+      : schema_(sealed_(parser)), staged_(schema_) {
+    const Schema &s = *schema_;
+    paths_ = s.config_paths_;
+    for (const std::string *path : s.config_path_ptrs_) {
+      if (!path->empty()) {
+        paths_.push_back(*path);
+      }
     }
-
-    if (!help_.empty()) {
-      result += "\n   " + help_;
+    tracked_.assign(s.args_.size(), Detail::no_slot);
+    for (std::uint32_t slot{0}; slot < s.args_.size(); ++slot) {
+      const Argument *arg = s.args_[slot];
+      if (arg->is_reloadable() && arg->source() <= Source::config) {
+        tracked_[slot] = static_cast<std::uint32_t>(slots_.size());
+        slots_.push_back(slot);
+      }
     }
-
-    if (has_default_ && !required_) {
-      std::ostringstream oss;
-      oss << default_val_;
-      result += " (default: " + oss.str() + ")";
+    text_.resize(slots_.size());
+    next_.resize(slots_.size());
+    changed_.resize(slots_.size());
+    // the text parse() converted, what later reloads compare against
+    Error error;
+    if (!scan_(error)) {
+      Detail::raise(ParseError(std::move(error)));
     }
+    text_.swap(next_);
+    files_.clear();
+  }
 
-    if (required_) {
-      result += " [required]";
-    }
+  ConfigWatcher(const ConfigWatcher &) = delete;
+  ConfigWatcher &operator=(const ConfigWatcher &) = delete;
 
-    return result;
-  }
+  ~ConfigWatcher() { stop(); }
 
-  TypedArgument &help(const std::string &help_text) {
-    help_ = help_text;
-    return *this;
-  }
+  /* the files read, in order */
+  const std::vector<std::string> &files() const { return paths_; }
 
-  TypedArgument &default_value(const T &value) {
-    default_val_ = value;
-    has_default_ = true;
-    if (!parsed_) {
-      *value_ptr_ = value;
+  /*
+   * Watch from a thread of its own until stop(). With inotify the
+   * directories of the files are watched, so an editor saving by renaming
+   * a new file over the old one is seen too, and a burst of events is
+   * reloaded once, settle after the last. Without inotify the files'
+   * modification time and size are checked every settle.
+   */
+  void start(std::chrono::milliseconds settle =
+                 std::chrono::milliseconds(50)) {
+    if (running()) {
+      return;
     }
-    return *this;
+#if INCANTI_HAS_INOTIFY
+    const int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || ::pipe2(stop_pipe_, O_CLOEXEC) != 0) {
+      const int err = errno;
+      if (fd >= 0) {
+        ::close(fd);
+      }
+      Detail::raise(ParseError(std::string("Cannot watch config files: ") +
+                               std::strerror(err)));
+    }
+    std::vector<Watch_> watches;
+    for (const std::string &path : paths_) {
+      const size_t slash = path.rfind('/');
+      std::string dir = ".";
+      if (slash != std::string::npos) {
+        dir = slash == 0 ? "/" : path.substr(0, slash);
+      }
+      const int wd =
+          ::inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+      if (wd < 0) {
+        const int err = errno;
+        ::close(fd);
+        close_stop_pipe_();
+        Detail::raise(ParseError("Cannot watch '" + dir +
+                                 "': " + std::strerror(err)));
+      }
+      watches.push_back({wd, path.substr(slash + 1)});
+    }
+    thread_ = std::thread([this, fd, settle, watches = std::move(watches)] {
+      report_(reload()); // changes made before the watches were set
+      watch_(fd, watches, settle);
+      ::close(fd);
+    });
+#else
+    stopping_ = false;
+    thread_ = std::thread([this, settle] { poll_(settle); });
+#endif
   }
 
-  TypedArgument &required() {
-    required_ = true;
-    return *this;
+  void stop() {
+    if (!thread_.joinable()) {
+      return;
+    }
+#if INCANTI_HAS_INOTIFY
+    const char wake{0};
+    while (::write(stop_pipe_[1], &wake, 1) < 0 && errno == EINTR) {
+    }
+    thread_.join();
+    close_stop_pipe_();
+#else
+    {
+      std::lock_guard<std::mutex> lock(stop_mutex_);
+      stopping_ = true;
+    }
+    stop_cv_.notify_all();
+    thread_.join();
+#endif
   }
 
-  TypedArgument &converter(std::function<T(const std::string &)> conv) {
-    str_to_T_ = conv;
-    return *this;
+  bool running() const { return thread_.joinable(); }
+
+  /* re-read the files now: the number of options published, or why
+   * nothing was. Change callbacks run on the calling thread and must not
+   * call reload() themselves. */
+  Expected<size_t> reload() {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    Error error;
+    const bool scanned = scan_(error) && stage_(error);
+    files_.clear();
+    if (!scanned) {
+      return Unexpected{std::move(error)};
+    }
+    const Schema &s = *schema_;
+    size_t published{0};
+    for (std::uint32_t t{0}; t < slots_.size(); ++t) {
+      if (changed_[t]) {
+        s.args_[slots_[t]]->publish(staged_.value_(slots_[t]));
+        text_[t].swap(next_[t]);
+        ++published;
+      }
+    }
+    if (published == 0) {
+      return size_t{0};
+    }
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    for (std::uint32_t t{0}; t < slots_.size(); ++t) {
+      if (changed_[t]) {
+        s.args_[slots_[t]]->notify();
+      }
+    }
+    return published;
   }
 
-  TypedArgument<T> &operator|(const char *help_text) {
-    help_ = help_text;
-    return *this;
+  /* failed reloads of the watcher thread, printed to stderr without one;
+   * set before start() */
+  template <typename Callback> void on_error(Callback &&callback) {
+    on_error_ = std::forward<Callback>(callback);
   }
 
-  TypedArgument<T> &operator|(const std::string &help_text) {
-    help_ = help_text;
-    return *this;
+  /* reloads that published anything */
+  std::uint64_t generation() const {
+    return generation_.load(std::memory_order_acquire);
   }
 
-  TypedArgument<T> &operator|(required_t) {
-    required_ = true;
-    return *this;
+private:
+  // an entry of a reloadable option in the files, as last scanned
+  struct Entry_ {
+    std::uint32_t slot;
+    std::uint32_t file;
+    std::string_view value;
+    size_t line;
+    size_t key_column;
+    size_t column;
+    bool element;
+  };
+
+  std::shared_ptr<const Schema> schema_;
+  std::vector<std::string> paths_;
+  // per option, its index in slots_ when reloadable, no_slot otherwise
+  std::vector<std::uint32_t> tracked_;
+  std::vector<std::uint32_t> slots_;
+  // text of each reloadable option as published, and as just scanned
+  std::vector<std::string> text_;
+  std::vector<std::string> next_;
+  std::vector<char> changed_;
+  std::vector<Entry_> entries_;
+  std::vector<Detail::MappedFile> files_;
+  // converted values waiting to be published
+  ParseResult staged_;
+  std::mutex reload_mutex_;
+  std::atomic<std::uint64_t> generation_{0};
+  std::function<void(const Error &)> on_error_;
+  std::thread thread_;
+#if INCANTI_HAS_INOTIFY
+  struct Watch_ {
+    int wd;
+    std::string name;
+  };
+  int stop_pipe_[2] = {-1, -1};
+#else
+  std::mutex stop_mutex_;
+  std::condition_variable stop_cv_;
+  bool stopping_ = false;
+#endif
+
+  static std::shared_ptr<const Schema> sealed_(Parser &parser) {
+    parser.seal();
+    return parser.schema_;
   }
 
-  template <typename U>
-  TypedArgument<T> &operator|(const default_wrapper<U> &def_val) {
-    static_assert(std::is_convertible_v<U, T>,
-                  "Default value must be convertible to argument type");
-    default_val_ = static_cast<T>(def_val.value);
-    has_default_ = true;
-    if (!parsed_) {
-      *value_ptr_ = default_val_;
+  /* maps the files and records the text of every reloadable option, a
+   * length prefixed value per entry; nothing is converted */
+  bool scan_(Error &error) {
+    const Schema &s = *schema_;
+    files_.clear();
+    entries_.clear();
+    for (std::string &text : next_) {
+      text.clear();
     }
-    return *this;
+    for (std::uint32_t f{0}; f < paths_.size(); ++f) {
+      files_.emplace_back();
+      Detail::MappedFile &file = files_.back();
+      if (!Detail::MappedFile::open(paths_[f], file, error.message)) {
+        error.code = ErrorCode::file_error;
+        return false;
+      }
+      auto on_entry = [&](const Detail::ConfigEntry &entry) {
+        const std::uint32_t slot = s.config_slot_(entry, paths_[f], error);
+        if (slot == OptionIndex::npos) {
+          return false;
+        }
+        const std::uint32_t t = tracked_[slot];
+        if (t == Detail::no_slot) {
+          return true; // read once, by parse()
+        }
+        entries_.push_back({slot, f, entry.value, entry.line,
+                            entry.key_column, entry.column, entry.element});
+        const size_t size = entry.value.size();
+        next_[t]
+            .append(reinterpret_cast<const char *>(&size), sizeof size)
+            .append(entry.value);
+        return true;
+      };
+      if (!Detail::scan_config(file.data(), file.size(), paths_[f], error,
+                               on_entry)) {
+        return false;
+      }
+    }
+    return true;
   }
 
-  template <typename Func, typename = std::enable_if_t<std::is_invocable_r_v<
-                               T, Func, const std::string &>>>
-  TypedArgument<T> &operator|(Func &&converter) {
-    str_to_T_ = std::forward<Func>(converter);
-    return *this;
+  /* converts the options whose text changed into staged_, from their
+   * default up, as parse() would have */
+  bool stage_(Error &error) {
+    const Schema &s = *schema_;
+    for (std::uint32_t t{0}; t < slots_.size(); ++t) {
+      changed_[t] = next_[t] != text_[t];
+      if (changed_[t]) {
+        const Argument *arg = s.args_[slots_[t]];
+        arg->restart(staged_.value_(slots_[t]));
+        staged_.sources_[slots_[t]] = arg->initial_source();
+      }
+    }
+    ParseResult::Sink_ sink{staged_};
+    Detail::ConfigLists lists;
+    std::uint32_t file{0};
+    for (const Entry_ &e : entries_) {
+      if (e.file != file) {
+        lists.seen.clear();
+        file = e.file;
+      }
+      if (!changed_[tracked_[e.slot]]) {
+        continue;
+      }
+      const Detail::ConfigEntry entry{s.args_[e.slot]->name(), e.value,
+                                      e.line,        e.key_column,
+                                      e.column,      e.element};
+      const bool replace = s.args_[e.slot]->is_list() &&
+                           lists.first(e.slot) &&
+                           sink.source(e.slot) == Source::config;
+      if (!s.store_config_(sink, e.slot, entry, paths_[e.file], error,
+                           replace)) {
+        return false;
+      }
+    }
+    return true;
   }
 
-private:
-  std::string name_;
-  std::string short_name_;
-  std::string help_;
-  T *value_ptr_;
-  T default_val_;
-  bool required_;
-  bool has_default_;
-  bool parsed_;
-  std::function<T(const std::string &value)> str_to_T_;
-
-  bool boolify_(const std::string &str) {
-    std::string lower = str;
-    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-    if (lower == "true" || lower == "1" || lower == "yes")
-      return true;
-    if (lower == "false" || lower == "0" || lower == "no")
-      return false;
-    throw ParseError("Invalid boolean value: " + str);
-  }
-
-  T converter_(const std::string &str) {
-    if constexpr (std::is_same_v<T, std::string>) {
-      return str;
-    } else if constexpr (std::is_same_v<T, int>) {
-      return std::stoi(str);
-    } else if constexpr (std::is_same_v<T, float>) {
-      return std::stof(str);
-    } else if constexpr (std::is_same_v<T, double>) {
-      return std::stod(str);
-    } else if constexpr (std::is_same_v<T, long>) {
-      return std::stol(str);
-    } else if constexpr (std::is_same_v<T, bool>) {
-      return boolify_(str);
+  void report_(const Expected<size_t> &reloaded) const {
+    if (reloaded) {
+      return;
+    }
+    if (on_error_) {
+      on_error_(reloaded.error());
     } else {
-      // todo: add link to docs.
-      throw ParseError("No default converter for this type. "
-                       "Please provide a custom .converter() for --" +
-                       name_);
+      std::fprintf(stderr, "incanti: %s\n", reloaded.error().message.c_str());
     }
   }
-};
 
-class FlagArgument : public Argument {
-public:
-  FlagArgument(const std::string &name, const std::string &short_name,
-               bool *value_ptr)
-      : name_(name), short_name_(short_name), value_ptr_(value_ptr),
-        parsed_(false) {
-    *value_ptr_ = false;
+#if INCANTI_HAS_INOTIFY
+  void close_stop_pipe_() {
+    for (int &fd : stop_pipe_) {
+      if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+      }
+    }
+  }
+
+  void watch_(int fd, const std::vector<Watch_> &watches,
+              std::chrono::milliseconds settle) {
+    pollfd fds[2] = {{fd, POLLIN, 0}, {stop_pipe_[0], POLLIN, 0}};
+    alignas(inotify_event) char buffer[4096];
+    using Clock = std::chrono::steady_clock;
+    // the reload is due settle after the first change, however many follow:
+    // a busy directory must not postpone it forever
+    bool pending{false};
+    Clock::time_point due;
+    for (;;) {
+      int timeout{-1};
+      if (pending) {
+        const auto left = std::chrono::ceil<std::chrono::milliseconds>(
+            due - Clock::now());
+        timeout = static_cast<int>(std::max<std::int64_t>(left.count(), 0));
+      }
+      const int ready = ::poll(fds, 2, timeout);
+      if (ready < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ready < 0 || fds[1].revents != 0) {
+        return;
+      }
+      bool changed{false};
+      ssize_t size;
+      while (ready > 0 && (size = ::read(fd, buffer, sizeof buffer)) > 0) {
+        for (char *p = buffer; p < buffer + size;) {
+          const auto *event = reinterpret_cast<const inotify_event *>(p);
+          if (event->mask & IN_Q_OVERFLOW) {
+            changed = true;
+          }
+          for (const Watch_ &watch : watches) {
+            if (event->wd == watch.wd && event->len > 0 &&
+                watch.name == event->name) {
+              changed = true;
+            }
+          }
+          p += sizeof(inotify_event) + event->len;
+        }
+      }
+      if (changed && !pending) {
+        pending = true;
+        due = Clock::now() + settle;
+      } else if (pending && Clock::now() >= due) {
+        pending = false;
+        report_(reload());
+      }
+    }
   }
+#else
+  /* modification time, size and inode of each file, zero when missing */
+  using Stamp_ = std::array<std::int64_t, 4>;
 
-  void parse(const std::string &value) override {
-    *value_ptr_ = true;
-    parsed_ = true;
+  std::vector<Stamp_> stamps_() const {
+    std::vector<Stamp_> stamps;
+    for (const std::string &path : paths_) {
+      Stamp_ stamp{};
+#if INCANTI_HAS_MMAP
+      struct stat st {};
+      if (::stat(path.c_str(), &st) == 0) {
+#if defined(__APPLE__)
+        const timespec &mtime = st.st_mtimespec;
+#else
+        const timespec &mtime = st.st_mtim;
+#endif
+        stamp = {static_cast<std::int64_t>(mtime.tv_sec),
+                 static_cast<std::int64_t>(mtime.tv_nsec),
+                 static_cast<std::int64_t>(st.st_size),
+                 static_cast<std::int64_t>(st.st_ino)};
+      }
+#else
+      std::ifstream in(path, std::ios::binary | std::ios::ate);
+      if (in) {
+        stamp[2] = static_cast<std::int64_t>(in.tellg());
+      }
+#endif
+      stamps.push_back(stamp);
+    }
+    return stamps;
   }
 
-  bool has_value() const override { return true; }
-  bool is_required() const override { return false; }
+  void poll_(std::chrono::milliseconds interval) {
+    auto stamps = stamps_();
+    report_(reload()); // changes made before the first stamps
+    std::unique_lock<std::mutex> lock(stop_mutex_);
+    while (!stop_cv_.wait_for(lock, interval, [this] { return stopping_; })) {
+      auto now = stamps_();
+      if (now != stamps) {
+        stamps = std::move(now);
+        lock.unlock();
+        report_(reload());
+        lock.lock();
+      }
+    }
+  }
+#endif
+};
 
-  std::string get_name() const override { return name_; }
+/* no default in a field descriptor, the member's own initializer stays */
+struct no_default_t {};
 
-  std::string get_help() const override {
-    std::string result;
-    if (short_name_.empty()) {
-      result += "-" + short_name_ + ", ";
-    }
-    result += "--" + name_;
+/*
+ * Compile-time descriptor of one member of an options struct:
+ *   field("threads", "t", &Options::threads) | "worker count" | def(4)
+ * Every part is a literal, so a whole table of fields can be constexpr.
+ * bool members are flags.
+ */
+template <typename S, typename M, typename D = no_default_t> struct Field {
+  using struct_type = S;
+  using member_type = M;
+  static constexpr bool has_default = !std::is_same_v<D, no_default_t>;
+  static constexpr bool is_flag = std::is_same_v<M, bool>;
 
-    if (!help_.empty()) {
-      result += "\n   " + help_;
-    }
+  std::string_view name;
+  std::string_view short_name;
+  M S::*member;
+  std::string_view help{};
+  D default_value{};
+  bool required = false;
+  char delimiter = ',';
 
-    return result;
+  constexpr Field operator|(const char *help_text) const {
+    Field f = *this;
+    f.help = help_text;
+    return f;
   }
 
-  FlagArgument &help(const std::string &help_text) {
-    help_ = help_text;
-    return *this;
+  constexpr Field operator|(required_t) const {
+    Field f = *this;
+    f.required = true;
+    return f;
   }
 
-  FlagArgument &operator|(const char *help_text) {
-    help_ = help_text;
-    return *this;
+  constexpr Field operator|(delimiter_wrapper delim) const {
+    static_assert(Detail::ListTraits<M>::is_list,
+                  "Only std::vector members take a delimiter");
+    Field f = *this;
+    f.delimiter = delim.value;
+    return f;
   }
 
-  FlagArgument &operator|(const std::string &help_text) {
-    help_ = help_text;
-    return *this;
+  template <typename U>
+  constexpr Field<S, M, U> operator|(const default_wrapper<U> &def_val) const {
+    static_assert(std::is_constructible_v<M, const U &>,
+                  "Default value must be convertible to the member type");
+    return {name,     short_name, member,   help, def_val.value,
+            required, delimiter};
   }
-
-private:
-  std::string name_;
-  std::string short_name_;
-  std::string help_;
-  bool *value_ptr_;
-  bool parsed_;
 };
 
-class Parser {
-public:
-  Parser(const std::string &program_name = "",
-         const std::string &program_desc = "")
-      : program_name_(program_name), program_desc_(program_desc),
-        help_added_(false) {
-    add_help_flag();
-  }
+/*
+ * Parser generated from a constexpr table of fields. Names, hashes and
+ * flags sit in arrays built by the compiler and every field has its own
+ * instantiated apply step, so nothing is registered or allocated before
+ * parse(); only values that own memory (strings, lists) allocate.
+ *
+ *   constexpr auto cli = Incanti::struct_parser(
+ *       field("input", "i", &Options::input) | required,
+ *       field("threads", "t", &Options::threads) | def(4));
+ *   Options options = cli.parse(argc, argv);
+ */
+template <typename... Fields> class StructParser {
+  static_assert(sizeof...(Fields) > 0, "A struct parser needs fields");
+  using S = typename std::tuple_element_t<0, std::tuple<Fields...>>::
+      struct_type;
+  static_assert((std::is_same_v<typename Fields::struct_type, S> && ...),
+                "All fields must belong to the same struct");
 
-  template <typename T>
-  TypedArgument<T> &arg(const std::string &name, const std::string &short_name,
-                        T *value_ptr) {
-    if (arguments_.find(name) != arguments_.end()) {
-      throw ParseError("Duplicate argument name: --" + name);
-    }
+public:
+  static constexpr size_t size = sizeof...(Fields);
 
-    if (!short_name.empty() &&
-        short_to_long_.find(short_name) != short_to_long_.end()) {
-      throw ParseError("Duplicate short option name: " + short_name +
-                       " (already used by --" + short_to_long_[short_name] +
-                       ")");
+  constexpr explicit StructParser(Fields... fields)
+      : fields_(fields...), names_{fields.name...},
+        shorts_{fields.short_name...}, hashes_{hash_name(fields.name)...},
+        flags_{Fields::is_flag...}, required_{fields.required...} {
+    // evaluated by the compiler for a constexpr parser: a bad table does
+    // not build
+    for (size_t i{0}; i < size; ++i) {
+      if (names_[i].empty() || names_[i] == "help" || shorts_[i] == "h") {
+        Detail::raise(ParseError("Invalid or reserved option name: --" +
+                                 std::string(names_[i])));
+      }
+      for (size_t j{0}; j < i; ++j) {
+        if (names_[i] == names_[j] ||
+            (!shorts_[i].empty() && shorts_[i] == shorts_[j])) {
+          Detail::raise(ParseError("Duplicate argument name: --" +
+                                   std::string(names_[i])));
+        }
+      }
     }
+  }
 
-    auto arg = std::make_shared<TypedArgument<T>>(name, short_name, value_ptr);
-    arguments_[name] = arg;
-    if (!short_name.empty()) {
-      short_to_long_[short_name] = name;
+  /* positional tokens go to positional, or are an error without it */
+  void parse(int argc, char *argv[], S &out,
+             std::vector<std::string> *positional = nullptr) const {
+    Expected<void> parsed = try_parse(argc, argv, out, positional);
+    if (!parsed) {
+      Detail::raise(ParseError(std::move(parsed.error())));
     }
-    return *arg;
   }
 
-  template <typename T>
-  TypedArgument<T> &arg(const std::string &name, T *value_ptr) {
-    return arg(name, "", value_ptr);
+  S parse(int argc, char *argv[]) const {
+    S out{};
+    parse(argc, argv, out);
+    return out;
   }
 
-  /* add args which are flags - true/false */
-  FlagArgument &flag(const std::string &name, const std::string &short_name,
-                     bool *value_ptr) {
-    if (arguments_.find(name) != arguments_.end()) {
-      throw ParseError("Duplicate argument name: --" + name);
-    }
+  /* parse() without exceptions */
+  Expected<void> try_parse(int argc, char *argv[], S &out,
+                           std::vector<std::string> *positional = nullptr)
+      const {
+    std::string_view program = argc > 0 ? argv[0] : "";
+    apply_defaults_(out, std::index_sequence_for<Fields...>{});
 
-    if (!short_name.empty() &&
-        short_to_long_.find(short_name) != short_to_long_.end()) {
-      throw ParseError("Duplicate short option name: " + short_name +
-                       " (already used by --" + short_to_long_[short_name] +
-                       ")");
+    std::array<bool, size> seen{};
+    Target_ target{*this, out, seen, positional, program};
+    TokenStream tokens(argc, argv, nullptr, 0);
+    Error error;
+    if (!Detail::scan_tokens(tokens, target, error)) {
+      return Unexpected{std::move(error)};
     }
 
-    auto arg = std::make_shared<FlagArgument>(name, short_name, value_ptr);
-    arguments_[name] = arg;
-    if (!short_name.empty()) {
-      short_to_long_[short_name] = name;
+    for (size_t i{0}; i < size; ++i) {
+      if (required_[i] && !seen[i]) {
+        error.code = ErrorCode::missing_required;
+        error.option = std::string(names_[i]);
+        error.message = "Required argument missing: --" + error.option;
+        return Unexpected{std::move(error)};
+      }
     }
-    return *arg;
+    return {};
   }
 
-  /* add args which are flags - true/false (when no short name) */
-  FlagArgument &flag(const std::string &name, bool *value_ptr) {
-    return flag(name, "", value_ptr);
+  Expected<S> try_parse(int argc, char *argv[]) const {
+    S out{};
+    Expected<void> parsed = try_parse(argc, argv, out);
+    if (!parsed) {
+      return Unexpected{std::move(parsed.error())};
+    }
+    return out;
   }
 
-  void parse(int argc, char *argv[]) {
-    if (argc > 0 && program_name_.empty()) {
-      program_name_ = argv[0];
+  /* the help screen at width columns (0: the terminal's); a constexpr
+   * parser has nowhere to keep it, so it is rendered on every call */
+  std::string help(std::string_view program, size_t width = 0) const {
+    std::array<size_t, size> order{};
+    for (size_t i{0}; i < size; ++i) {
+      order[i] = i;
     }
+    std::sort(order.begin(), order.end(),
+              [this](size_t a, size_t b) { return names_[a] < names_[b]; });
 
-    for (int i{1}; i < argc; ++i) {
-      std::string arg = argv[i];
-
-      if (arg == "-h" || arg == "--help") {
-        print_help();
-        exit(0);
+    Detail::HelpLayout layout(width ? width : Detail::terminal_width());
+    std::string spec;
+    std::string text;
+    auto help_row = [&] {
+      spec.clear();
+      text.clear();
+      Detail::help_spec(spec, "help", "h", "");
+      Detail::help_text(text, "Show this help message", "", "", false);
+      layout.add(spec, text);
+    };
+    bool help_listed{false};
+    for (size_t i : order) {
+      if (!help_listed && names_[i] > "help") {
+        help_row();
+        help_listed = true;
       }
+      entry_(i, spec, text, std::index_sequence_for<Fields...>{});
+      layout.add(spec, text);
+    }
+    if (!help_listed) {
+      help_row();
+    }
 
-      /* long options, starting with '--' */
-      if (arg.substr(0, 2) == "--") {
-        std::string name = arg.substr(2);
-        std::string value;
-
-        // also support : "./prog --index=a1"
-        size_t eq = name.find("=");
-        if (eq != std::string::npos) {
-          value = name.substr(eq + 1);
-          name = name.substr(0, eq);
-        }
-
-        auto it = arguments_.find(name);
-        if (it == arguments_.end()) {
-          throw ParseError("Unknown Argument: --" + name);
-        }
-
-        auto flag_arg = dynamic_cast<FlagArgument *>(it->second.get());
-        if (flag_arg) {
-          flag_arg->parse("");
-        } else {
-          if (value.empty()) {
-            if (i + 1 >= argc) {
-              throw ParseError("Argument --" + name + " requires a value");
-            }
-            value = argv[++i];
-          }
-          it->second->parse(value);
-        }
-      } else if (arg[0] == '-' && arg.length() > 1 && arg[1] != '-') {
-        /* short options, starting with '-' */
-        std::string short_name = arg.substr(1);
-
-        auto exact_match = short_to_long_.find(short_name);
-        if (exact_match != short_to_long_.end()) {
-          auto arg_it = arguments_.find(exact_match->second);
-          auto flag_arg = dynamic_cast<FlagArgument *>(arg_it->second.get());
-          if (flag_arg) {
-            flag_arg->parse("");
-          } else {
-            if (i + 1 >= argc) {
-              throw ParseError("Argument -" + short_name + " requires a value");
-            }
-            std::string next_arg = argv[i + 1];
-            if (next_arg.empty() || next_arg[0] == '-') {
-              throw ParseError("Argument -" + short_name + " requires a value");
-            }
-            arg_it->second->parse(argv[++i]);
-          }
-          continue;
-        }
+    std::string out;
+    layout.render(out, program, {});
+    return out;
+  }
 
-        /* we try to find the longest registered short optio  that matches
-         beginning of what the user provided. */
-        std::string rsn;
-        std::string value_part;
+  void print_help(std::string_view program,
+                  std::ostream &out = std::cout) const {
+    std::string text = help(program);
+    if (&out == &std::cout) {
+      Detail::write_stdout(text);
+    } else {
+      out.write(text.data(), static_cast<std::streamsize>(text.size()));
+      out.flush();
+    }
+  }
 
-        for (const auto &[short_opt, long_name] : short_to_long_) {
-          if (short_opt.length() > 1 &&
-              short_name.length() > short_opt.length() &&
-              short_name.substr(0, short_opt.length()) == short_opt) {
-            if (short_opt.length() > rsn.length()) {
-              rsn = short_opt;
-              value_part = short_name.substr(short_opt.length());
-            }
-          }
-        }
+private:
+  std::tuple<Fields...> fields_;
+  std::array<std::string_view, size> names_;
+  std::array<std::string_view, size> shorts_;
+  std::array<std::uint64_t, size> hashes_;
+  std::array<bool, size> flags_;
+  std::array<bool, size> required_;
 
-        if (!rsn.empty()) {
-          auto arg_it = arguments_.find(short_to_long_[rsn]);
-          auto flag_arg = dynamic_cast<FlagArgument *>(arg_it->second.get());
+  struct Target_ {
+    const StructParser &p;
+    S &out;
+    std::array<bool, size> &seen;
+    std::vector<std::string> *positionals;
+    std::string_view program;
 
-          if (flag_arg) {
-            throw ParseError("Flag -" + rsn +
-                             " doesn't accept a value, but got: " + value_part);
-          } else {
-            arg_it->second->parse(value_part);
-          }
-          continue;
+    std::uint32_t find_long(std::string_view name) const {
+      const std::uint64_t h = hash_name(name);
+      for (size_t i{0}; i < size; ++i) {
+        if (p.hashes_[i] == h && p.names_[i] == name) {
+          return static_cast<std::uint32_t>(i);
         }
-
-        bool combi_flags{true}; // single
-        for (size_t j = 0; j < short_name.length(); ++j) {
-          std::string single_char(1, short_name[j]);
-          auto it = short_to_long_.find(single_char);
-          if (it == short_to_long_.end()) {
-            combi_flags = false;
-            break;
-          }
-          auto arg_it = arguments_.find(it->second);
-          auto flag_arg = dynamic_cast<FlagArgument *>(arg_it->second.get());
-          if (!flag_arg) {
-            combi_flags = false;
-            break;
-          }
+      }
+      return Detail::no_slot;
+    }
+    std::uint32_t find_short(std::string_view name) const {
+      for (size_t i{0}; i < size; ++i) {
+        if (!p.shorts_[i].empty() && p.shorts_[i] == name) {
+          return static_cast<std::uint32_t>(i);
         }
-
-        if (combi_flags) {
-          for (size_t j{0}; j < short_name.length(); ++j) {
-            std::string single_char(1, short_name[j]);
-            auto it = short_to_long_.find(single_char);
-            auto arg_it = arguments_.find(it->second);
-            auto flag_arg = dynamic_cast<FlagArgument *>(arg_it->second.get());
-            flag_arg->parse("");
-          }
-          continue;
+      }
+      return Detail::no_slot;
+    }
+    std::uint32_t short_prefix(std::string_view token, size_t &length) const {
+      std::uint32_t best{Detail::no_slot};
+      length = 0;
+      for (size_t i{0}; i < size; ++i) {
+        std::string_view s = p.shorts_[i];
+        if (s.size() > 1 && s.size() < token.size() && s.size() > length &&
+            token.substr(0, s.size()) == s) {
+          best = static_cast<std::uint32_t>(i);
+          length = s.size();
         }
-
-        /* single char parsing | combining of different flags like : '-vdi' */
-        for (size_t j{0}; j < short_name.length(); ++j) {
-          std::string short_opt(1, short_name[j]);
-          auto it = short_to_long_.find(short_opt);
-          if (it == short_to_long_.end()) {
-            throw ParseError("Unknown argument: -" + short_opt);
-          }
-
-          auto arg_it = arguments_.find(it->second);
-          auto flag_arg = dynamic_cast<FlagArgument *>(arg_it->second.get());
-
-          if (flag_arg) {
-            flag_arg->parse("");
-          } else {
-            if (j < short_name.length() - 1) {
-              // value is attached to single char: -ofile.txt | -vfd
-              arg_it->second->parse(short_name.substr(j + 1));
-              break;
-            } else if (i + 1 >= argc) {
-              throw ParseError("Argument -" + short_opt + " requires a value");
-            } else {
-              arg_it->second->parse(argv[++i]);
-            }
-          }
+      }
+      return best;
+    }
+    std::uint32_t find_char(char c) const {
+      return find_short(std::string_view(&c, 1));
+    }
+    bool is_flag(std::uint32_t slot) const { return p.flags_[slot]; }
+    std::string_view name(std::uint32_t slot) const { return p.names_[slot]; }
+    // a handful of names, no tree needed
+    void suggest(Detail::NearMatches &near) const {
+      for (size_t i{0}; i < size; ++i) {
+        near.offer("--", p.names_[i]);
+        if (!p.shorts_[i].empty()) {
+          near.offer("-", p.shorts_[i]);
         }
-      } else {
-        positionals_.push_back(arg);
       }
     }
-
-    for (const auto &[name, arg] : arguments_) {
-      if (arg->is_required() && !arg->has_value()) {
-        throw ParseError("Required argument missing: --" + name);
+    bool apply(std::uint32_t slot, std::string_view value,
+               const Detail::Origin &, Error &error) {
+      return p.apply_(slot, out, value, seen, error,
+                      std::index_sequence_for<Fields...>{});
+    }
+    bool positional(std::string_view token, Error &) {
+      if (!positionals) {
+        return false;
       }
+      positionals->emplace_back(token);
+      return true;
     }
-  }
+    void help() {
+      p.print_help(program);
+      exit(0);
+    }
+  };
 
-  const std::vector<std::string> &positional() const { return positionals_; }
+  template <size_t... I>
+  void apply_defaults_(S &out, std::index_sequence<I...>) const {
+    (default_<I>(out), ...);
+  }
 
-  void print_help() {
-    if (!program_name_.empty()) {
-      std::cout << "Usage: " << program_name_ << " [options]" << std::endl;
+  template <size_t I> void default_(S &out) const {
+    const auto &f = std::get<I>(fields_);
+    using M = typename std::tuple_element_t<I, std::tuple<Fields...>>::
+        member_type;
+    if constexpr (std::tuple_element_t<I, std::tuple<Fields...>>::has_default) {
+      out.*f.member = M(f.default_value);
+    } else if constexpr (Detail::ListTraits<M>::is_list) {
+      (out.*f.member).clear();
     }
+  }
 
-    if (!program_desc_.empty()) {
-      std::cout << program_desc_ << std::endl;
-    }
+  template <size_t... I>
+  bool apply_(std::uint32_t slot, S &out, std::string_view value,
+              std::array<bool, size> &seen, Error &error,
+              std::index_sequence<I...>) const {
+    bool applied{false};
+    ((slot == I ? (applied = apply_one_<I>(out, value, seen[I], error), true)
+                : false) ||
+     ...);
+    return applied;
+  }
 
-    std::cout << "\nOptions: " << std::endl;
-    for (const auto &[name, arg] : arguments_) {
-      std::cout << arg->get_help() << std::endl;
+  template <size_t I>
+  bool apply_one_(S &out, std::string_view value, bool &seen,
+                  Error &error) const {
+    const auto &f = std::get<I>(fields_);
+    using M = typename std::tuple_element_t<I, std::tuple<Fields...>>::
+        member_type;
+    M &member = out.*f.member;
+    bool stored = true;
+    if constexpr (std::is_same_v<M, bool>) {
+      member = true;
+    } else if constexpr (Detail::ListTraits<M>::is_list) {
+      using E = typename Detail::ListTraits<M>::element_type;
+      if (!seen) {
+        member.clear(); // the first occurrence replaces the default
+      }
+      stored = Detail::split_list(
+          member, value, f.delimiter, error,
+          [&](std::string_view item, size_t i) {
+            return Detail::convert_element<E>(item, i, f.name, error);
+          });
+    } else if constexpr (std::is_same_v<M, std::string>) {
+      member.assign(value.data(), value.size());
+    } else {
+      std::optional<M> converted =
+          Detail::convert_value<M>(value, f.name, error);
+      stored = converted.has_value();
+      if (stored) {
+        member = *converted;
+      }
+    }
+    if (!stored) {
+      error.code = ErrorCode::invalid_value;
+      error.option = std::string(f.name);
+      error.message = "Failed to parse '" + std::string(value) +
+                      "' for argument --" + std::string(f.name) + ": " +
+                      error.message;
+      return false;
     }
+    seen = true;
+    return true;
   }
 
-private:
-  std::string program_name_;
-  std::string program_desc_;
-  std::map<std::string, std::shared_ptr<Argument>> arguments_;
-  std::map<std::string, std::string> short_to_long_;
-  std::vector<std::string> positionals_;
-  bool help_added_;
+  template <size_t... I>
+  void entry_(size_t slot, std::string &spec, std::string &text,
+              std::index_sequence<I...>) const {
+    ((slot == I ? (entry_one_<I>(spec, text), true) : false) || ...);
+  }
 
-  void add_help_flag() {
-    if (!help_added_) {
-      auto help_flag =
-          std::make_shared<FlagArgument>("help", "h", new bool(false));
-      help_flag->help("Show this help message");
-      arguments_["help"] = help_flag;
-      short_to_long_["h"] = "help";
-      help_added_ = true;
+  template <size_t I>
+  void entry_one_(std::string &spec, std::string &text) const {
+    using F = std::tuple_element_t<I, std::tuple<Fields...>>;
+    using M = typename F::member_type;
+    const F &f = std::get<I>(fields_);
+
+    std::string hint;
+    if constexpr (!F::is_flag) {
+      hint = " <value>";
+      if constexpr (Detail::ListTraits<M>::is_list) {
+        if (f.delimiter) {
+          hint.append(1, f.delimiter).append("...");
+        } else {
+          hint += "...";
+        }
+      }
     }
+
+    std::string default_text;
+    if constexpr (F::has_default &&
+                  Detail::IsStreamable<decltype(f.default_value)>::value) {
+      std::ostringstream oss;
+      oss << f.default_value;
+      default_text = oss.str();
+    }
+
+    spec.clear();
+    text.clear();
+    Detail::help_spec(spec, f.name, f.short_name, hint);
+    Detail::help_text(text, f.help, default_text, "", f.required);
   }
 };
+
+template <typename... Fields>
+constexpr StructParser<Fields...> struct_parser(Fields... fields) {
+  return StructParser<Fields...>(fields...);
+}
 } // namespace Incanti
 
 inline constexpr Incanti::required_t required{};
@@ -533,31 +7178,105 @@ template <typename T> constexpr auto def(T &&value) {
   return Incanti::default_wrapper<std::decay_t<T>>{std::forward<T>(value)};
 }
 
+constexpr Incanti::delimiter_wrapper sep(char delimiter) { return {delimiter}; }
+
+constexpr Incanti::env_wrapper env(std::string_view name) { return {name}; }
+
+template <typename F>
+Incanti::change_wrapper<std::decay_t<F>> on_change(F &&callback) {
+  return {std::forward<F>(callback)};
+}
+
+template <typename... Values>
+constexpr Incanti::choices_wrapper<sizeof...(Values)>
+choices(Values... values) {
+  return {{std::string_view(values)...}};
+}
+
+template <typename S, typename M>
+constexpr Incanti::Field<S, M> field(std::string_view name,
+                                     std::string_view short_name,
+                                     M S::*member) {
+  return {name, short_name, member};
+}
+template <typename S, typename M>
+constexpr Incanti::Field<S, M> field(std::string_view name, M S::*member) {
+  return {name, "", member};
+}
+
 template <typename T>
-Incanti::ArgP<T> arg(std::string name, std::string short_name, T *value_ptr) {
-  return Incanti::ArgP<T>{std::move(name), std::move(short_name), value_ptr};
+Incanti::ArgP<T> arg(std::string_view name, std::string_view short_name,
+                     T *value_ptr) {
+  return Incanti::ArgP<T>{name, short_name, value_ptr};
 }
-template <typename T> Incanti::ArgP<T> arg(std::string name, T *value_ptr) {
-  return arg(std::move(name), "", value_ptr);
+template <typename T>
+Incanti::ArgP<T> arg(std::string_view name, T *value_ptr) {
+  return arg(name, "", value_ptr);
 }
 
-inline Incanti::FlagP flag(std::string name, std::string short_name,
+inline Incanti::FlagP flag(std::string_view name, std::string_view short_name,
                            bool *value_ptr) {
-  return Incanti::FlagP{std::move(name), std::move(short_name), value_ptr};
+  return Incanti::FlagP{name, short_name, value_ptr};
 }
-inline Incanti::FlagP flag(std::string name, bool *value_ptr) {
-  return Incanti::FlagP{std::move(name), "", value_ptr};
+inline Incanti::FlagP flag(std::string_view name, bool *value_ptr) {
+  return Incanti::FlagP{name, "", value_ptr};
 }
 
 template <typename T>
 Incanti::TypedArgument<T> &operator>>(Incanti::Parser &parser,
                                       Incanti::ArgP<T> p) {
-  return parser.arg(std::move(p.name), std::move(p.short_name), p.value_ptr);
+  return parser.arg(p.name, p.short_name, p.value_ptr);
 }
 
 inline Incanti::FlagArgument &operator>>(Incanti::Parser &parser,
                                          Incanti::FlagP p) {
-  return parser.flag(std::move(p.name), std::move(p.short_name), p.value_ptr);
+  return parser.flag(p.name, p.short_name, p.value_ptr);
+}
+
+#if INCANTI_STATS && defined(INCANTI_STATS_COUNT_NEW)
+// counting operator new for Stats::allocations; this translation unit only.
+// Every plain and nothrow form is replaced so that they all pair up
+#if defined(__GNUC__) && !defined(__clang__)
+// gcc flags free() in the replaced operator delete once both are inlined
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  Incanti::note_allocation(size);
+  return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return operator new(size, std::nothrow);
+}
+
+void *operator new(std::size_t size) {
+  if (void *p = operator new(size, std::nothrow)) {
+    return p;
+  }
+#if INCANTI_EXCEPTIONS
+  throw std::bad_alloc();
+#else
+  std::abort();
+#endif
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
 }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
 
 #endif //! INCANTI_HPP
@@ -0,0 +1,1969 @@
+#include "incanti.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <spawn.h>
+#include <sys/wait.h>
+#endif
+
+#if __has_include(<getopt.h>)
+#include <getopt.h>
+#define INCANTI_BENCH_GETOPT 1
+#else
+#define INCANTI_BENCH_GETOPT 0
+#endif
+
+/*
+ * micro benchmarks for incanti, run a release build for meaningful numbers.
+ *
+ *   incanti_bench [--format table|csv|json] [--only scenario,...]
+ *
+ * Where glibc getopt_long is available the same command lines are parsed
+ * with it as a baseline (getopt_* columns).
+ */
+
+/* every heap allocation in the process goes through this counter */
+#if defined(__GNUC__) && !defined(__clang__)
+// gcc flags free() in the replaced operator delete once both are inlined
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<std::uint64_t> allocation_count{0};
+
+void *operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  Incanti::note_allocation(size); // Stats::allocations, INCANTI_STATS builds
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+#if INCANTI_EXCEPTIONS
+  throw std::bad_alloc();
+#else
+  std::abort();
+#endif
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+volatile std::uint64_t sink;
+
+template <typename Fn> double ns_per_op(size_t ops, Fn &&fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         static_cast<double>(ops);
+}
+
+/* heap allocations made by fn, divided by ops */
+template <typename Fn> double allocs_per_op(size_t ops, Fn &&fn) {
+  const std::uint64_t before = allocation_count;
+  fn();
+  return static_cast<double>(allocation_count - before) /
+         static_cast<double>(ops);
+}
+
+std::vector<std::string> option_names(size_t count) {
+  std::vector<std::string> names;
+  names.reserve(count);
+  for (size_t i{0}; i < count; ++i) {
+    names.push_back("option-name-" + std::to_string(i));
+  }
+  return names;
+}
+
+/* owns the strings of a command line and hands out a char ** view of it */
+struct CommandLine {
+  std::vector<std::string> tokens{"bench"};
+  std::vector<char *> argv;
+
+  void push(std::string token) { tokens.push_back(std::move(token)); }
+
+  char **data() {
+    argv.clear();
+    for (auto &t : tokens) {
+      argv.push_back(t.data());
+    }
+    argv.push_back(nullptr);
+    return argv.data();
+  }
+
+  int argc() const { return static_cast<int>(tokens.size()); }
+};
+
+using Metrics = std::vector<std::pair<const char *, double>>;
+
+/* one measured case: a row in the table, an object in the json */
+struct Row {
+  std::string scenario;
+  std::string name;
+  const char *param;
+  size_t n;
+  Metrics metrics;
+};
+
+std::vector<Row> rows;
+
+void record(const char *scenario, std::string name, const char *param,
+            size_t n, Metrics metrics) {
+  rows.push_back({scenario, std::move(name), param, n, std::move(metrics)});
+}
+
+void print_table() {
+  const Row *prev{nullptr};
+  for (const Row &row : rows) {
+    if (!prev || prev->scenario != row.scenario) {
+      std::printf("\n%-16s %-16s %10s", row.scenario.c_str(), "", row.param);
+      for (const auto &metric : row.metrics) {
+        std::printf(" %14s", metric.first);
+      }
+      std::printf("\n");
+    }
+    std::printf("%-16s %-16s %10zu", "", row.name.c_str(), row.n);
+    for (const auto &metric : row.metrics) {
+      std::printf(" %14.2f", metric.second);
+    }
+    std::printf("\n");
+    prev = &row;
+  }
+}
+
+/* long format, one line per metric, so new metrics keep the columns stable */
+void print_csv() {
+  std::printf("scenario,case,param,n,metric,value\n");
+  for (const Row &row : rows) {
+    for (const auto &metric : row.metrics) {
+      std::printf("%s,%s,%s,%zu,%s,%.3f\n", row.scenario.c_str(),
+                  row.name.c_str(), row.param, row.n, metric.first,
+                  metric.second);
+    }
+  }
+}
+
+void print_json() {
+  std::printf("{\n  \"getopt_long\": %s,\n  \"results\": [",
+              INCANTI_BENCH_GETOPT ? "true" : "false");
+  for (size_t i{0}; i < rows.size(); ++i) {
+    const Row &row = rows[i];
+    std::printf("%s\n    {\"scenario\": \"%s\", \"case\": \"%s\", "
+                "\"param\": \"%s\", \"n\": %zu",
+                i ? "," : "", row.scenario.c_str(), row.name.c_str(),
+                row.param, row.n);
+    for (const auto &metric : row.metrics) {
+      std::printf(", \"%s\": %.3f", metric.first, metric.second);
+    }
+    std::printf("}");
+  }
+  std::printf("\n  ]\n}\n");
+}
+
+#if INCANTI_BENCH_GETOPT
+/* getopt_long over argv, converting values the way a hand written main()
+ * would. glibc restarts its scan when optind is 0. */
+template <typename OnOption>
+void getopt_parse(int argc, char **argv, const char *shorts,
+                  const option *longs, OnOption &&on_option) {
+  optind = 0;
+  opterr = 0;
+  int index{0};
+  int c;
+  while ((c = getopt_long(argc, argv, shorts, longs, &index)) != -1) {
+    on_option(c);
+  }
+}
+#endif
+
+/* name -> slot lookup cost against the number of registered options */
+void bench_lookup() {
+  for (size_t count : {8, 32, 128, 512, 2048, 8192}) {
+    auto names = option_names(count);
+
+    std::map<std::string, std::uint32_t> map;
+    std::vector<Incanti::OptionIndex::Key> keys;
+    for (size_t i{0}; i < count; ++i) {
+      map[names[i]] = static_cast<std::uint32_t>(i);
+      keys.push_back({names[i], Incanti::OptionIndex::Kind::long_name,
+                      static_cast<std::uint32_t>(i)});
+    }
+    Incanti::OptionIndex index;
+    index.build(keys);
+
+    const size_t rounds = std::max<size_t>(1, 2000000 / count);
+    const size_t ops = rounds * count;
+
+    double map_ns = ns_per_op(ops, [&] {
+      std::uint64_t acc{0};
+      for (size_t r{0}; r < rounds; ++r) {
+        for (const auto &name : names) {
+          acc += map.find(name)->second;
+        }
+      }
+      sink = acc;
+    });
+
+    double index_ns = ns_per_op(ops, [&] {
+      std::uint64_t acc{0};
+      for (size_t r{0}; r < rounds; ++r) {
+        for (const auto &name : names) {
+          acc += index.find(Incanti::OptionIndex::Kind::long_name, name);
+        }
+      }
+      sink = acc;
+    });
+
+    record("lookup", "long name", "options", count,
+           {{"map_ns", map_ns}, {"index_ns", index_ns}});
+  }
+}
+
+/* building a schema of N options, and what it occupies per option.
+ * getopt_long has no registration step, its table is static data. */
+void bench_registration() {
+  for (size_t count : {8, 32, 128, 512, 2048}) {
+    auto names = option_names(count);
+    std::vector<int> values(count);
+
+    const size_t rounds = std::max<size_t>(1, 20000 / count);
+    double ns{0};
+    double allocs = allocs_per_op(rounds, [&] {
+      ns = ns_per_op(rounds, [&] {
+        for (size_t r{0}; r < rounds; ++r) {
+          Incanti::Parser parser("bench");
+          for (size_t i{0}; i < count; ++i) {
+            parser >> arg(names[i], &values[i]) | "help text for the option";
+          }
+          parser.seal();
+        }
+      });
+    });
+
+    Incanti::Parser parser("bench");
+    for (size_t i{0}; i < count; ++i) {
+      parser >> arg(names[i], &values[i]) | "help text for the option";
+    }
+    parser.seal();
+    auto usage = parser.memory_usage();
+
+    record("registration", "arg+help+seal", "options", count,
+           {{"us", ns / 1000.0},
+            {"allocs", allocs},
+            {"bytes_option", usage.per_option()}});
+  }
+}
+
+/* full parse() of a 32-token command line on a sealed schema */
+void bench_sealed_parse() {
+  for (size_t count : {8, 32, 128, 512, 2048}) {
+    auto names = option_names(count);
+    std::vector<int> values(count);
+
+    Incanti::Parser parser("bench");
+    for (size_t i{0}; i < count; ++i) {
+      parser >> arg(names[i], &values[i]);
+    }
+    parser.seal();
+
+    CommandLine line;
+    for (size_t i{0}; i < 16; ++i) {
+      line.push("--" + names[(i * 7919) % count]);
+      line.push(std::to_string(i));
+    }
+    char **argv = line.data();
+
+    const size_t rounds = 20000;
+    double ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        parser.parse(line.argc(), argv);
+      }
+    });
+    record("parse_sealed", "32 tokens", "options", count, {{"ns", ns}});
+  }
+}
+
+/* parse() latency against argc: --option-name-i <value> pairs over a
+ * 64 option schema, against getopt_long with strtol on the same line */
+void bench_argc() {
+  const size_t count = 64;
+  auto names = option_names(count);
+  std::vector<int> values(count);
+
+  Incanti::Parser parser("bench");
+  for (size_t i{0}; i < count; ++i) {
+    parser >> arg(names[i], &values[i]);
+  }
+  parser.seal();
+
+#if INCANTI_BENCH_GETOPT
+  std::vector<option> longs;
+  for (size_t i{0}; i < count; ++i) {
+    longs.push_back({names[i].c_str(), required_argument, nullptr,
+                     static_cast<int>(256 + i)});
+  }
+  longs.push_back({nullptr, 0, nullptr, 0});
+#endif
+
+  for (size_t pairs : {1, 4, 16, 64, 256}) {
+    CommandLine line;
+    for (size_t i{0}; i < pairs; ++i) {
+      line.push("--" + names[(i * 31) % count]);
+      line.push(std::to_string(i * 13));
+    }
+    char **argv = line.data();
+
+    const size_t rounds = std::max<size_t>(1, 400000 / pairs);
+    double ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        parser.parse(line.argc(), argv);
+      }
+    });
+    Metrics metrics{{"incanti_ns", ns}};
+
+#if INCANTI_BENCH_GETOPT
+    double getopt_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        getopt_parse(line.argc(), argv, "", longs.data(), [&](int c) {
+          values[static_cast<size_t>(c - 256)] =
+              static_cast<int>(std::strtol(optarg, nullptr, 10));
+        });
+      }
+    });
+    metrics.push_back({"getopt_ns", getopt_ns});
+#endif
+    record("parse_argc", "--name value", "argc",
+           static_cast<size_t>(line.argc()), std::move(metrics));
+  }
+}
+
+/* the spellings of an option, each command line repeats one 8 times */
+void bench_forms() {
+  int level{0};
+  bool a{false}, b{false}, c{false}, d{false};
+
+  Incanti::Parser parser("bench");
+  parser >> arg("level", "l", &level);
+  parser >> flag("alpha", "a", &a);
+  parser >> flag("bravo", "b", &b);
+  parser >> flag("charlie", "c", &c);
+  parser >> flag("delta", "d", &d);
+  parser.seal();
+
+#if INCANTI_BENCH_GETOPT
+  const option longs[] = {{"level", required_argument, nullptr, 'l'},
+                          {"alpha", no_argument, nullptr, 'a'},
+                          {"bravo", no_argument, nullptr, 'b'},
+                          {"charlie", no_argument, nullptr, 'c'},
+                          {"delta", no_argument, nullptr, 'd'},
+                          {nullptr, 0, nullptr, 0}};
+#endif
+
+  struct Form {
+    const char *name;
+    std::vector<std::string> tokens;
+  };
+  const Form forms[] = {{"long", {"--level", "7"}},
+                        {"long=", {"--level=7"}},
+                        {"short", {"-l", "7"}},
+                        {"attached", {"-l7"}},
+                        {"clustered", {"-abcd"}},
+                        {"cluster+value", {"-abcl7"}}};
+
+  for (const Form &form : forms) {
+    CommandLine line;
+    for (size_t i{0}; i < 8; ++i) {
+      for (const auto &token : form.tokens) {
+        line.push(token);
+      }
+    }
+    char **argv = line.data();
+
+    const size_t rounds = 200000;
+    double ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        parser.parse(line.argc(), argv);
+      }
+    });
+    Metrics metrics{{"incanti_ns", ns}};
+
+#if INCANTI_BENCH_GETOPT
+    double getopt_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        getopt_parse(line.argc(), argv, "abcdl:", longs, [&](int opt) {
+          if (opt == 'l') {
+            level = static_cast<int>(std::strtol(optarg, nullptr, 10));
+          } else {
+            sink = static_cast<std::uint64_t>(opt);
+          }
+        });
+      }
+    });
+    metrics.push_back({"getopt_ns", getopt_ns});
+#endif
+    record("parse_forms", form.name, "argc", static_cast<size_t>(line.argc()),
+           std::move(metrics));
+  }
+}
+
+/* -abcdefgh... flag clusters, with a growing number of unrelated options
+ * registered next to the 51 single character flags */
+void bench_clusters() {
+  const std::string letters =
+      "abcdefgijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"; // no -h
+  for (size_t extra : {0, 2048}) {
+    auto names = option_names(extra);
+    std::vector<int> values(extra);
+    bool flags[64]{};
+
+    Incanti::Parser parser("bench");
+    for (size_t i{0}; i < letters.size(); ++i) {
+      parser >> flag("flag-" + std::string(1, letters[i]),
+                     std::string(1, letters[i]), &flags[i]);
+    }
+    for (size_t i{0}; i < extra; ++i) {
+      parser >> arg(names[i], "x" + std::to_string(i), &values[i]);
+    }
+    parser.seal();
+
+    for (size_t length : {4, 16, 51}) {
+      std::string cluster = "-" + letters.substr(0, length);
+      char program[] = "bench";
+      char *argv[] = {program, cluster.data()};
+
+      const size_t rounds = 200000;
+      double ns = ns_per_op(rounds, [&] {
+        for (size_t r{0}; r < rounds; ++r) {
+          parser.parse(2, argv);
+        }
+      });
+      record("short_clusters",
+             std::to_string(letters.size() + extra) + " options", "cluster",
+             length, {{"ns", ns}, {"ns_char", ns / length}});
+    }
+  }
+}
+
+/* a response file with a million entries, tokenized from the mapping */
+void bench_response_file() {
+  const size_t entries = 1000000;
+  auto path =
+      (std::filesystem::temp_directory_path() / "incanti_bench.rsp").string();
+  {
+    std::ofstream out(path);
+    for (size_t i{0}; i < entries / 2; ++i) {
+      out << "--level " << (i % 1000) << (i % 8 == 0 ? "\n" : " ");
+    }
+  }
+
+  int level{0};
+  Incanti::Parser parser("bench");
+  parser >> arg("level", "l", &level);
+  parser.response_files();
+  parser.seal();
+
+  std::string token = "@" + path;
+  char program[] = "bench";
+  char *argv[] = {program, token.data()};
+
+  const size_t rounds = 5;
+  double ns = ns_per_op(rounds, [&] {
+    for (size_t r{0}; r < rounds; ++r) {
+      parser.parse(2, argv);
+    }
+  });
+  std::filesystem::remove(path);
+
+  record("response_file", "--level N", "entries", entries,
+         {{"ms", ns / 1e6}, {"ns_entry", ns / entries}});
+}
+
+/* a generated 100k line config file over 2048 options, streamed from the
+ * mapping, against reading it into a std::map<std::string, std::string>
+ * with getline and converting from there */
+void bench_config() {
+  const size_t lines = 100000;
+  const size_t count = 2048;
+  auto names = option_names(count);
+  auto path =
+      (std::filesystem::temp_directory_path() / "incanti_bench.toml").string();
+  {
+    std::ofstream out(path);
+    out << "# generated\n";
+    for (size_t i{0}; i < lines; ++i) {
+      out << names[i % count] << " = " << (i % 10000)
+          << (i % 16 == 0 ? "  # note\n" : "\n");
+    }
+  }
+
+  std::vector<int> values(count);
+  Incanti::Parser parser("bench");
+  for (size_t i{0}; i < count; ++i) {
+    parser >> arg(names[i], &values[i]);
+  }
+  parser.config_file(path);
+  parser.seal();
+  char program[] = "bench";
+  char *argv[] = {program, nullptr};
+
+  const size_t rounds = 5;
+  double naive_ns = ns_per_op(rounds, [&] {
+    for (size_t r{0}; r < rounds; ++r) {
+      std::map<std::string, std::string> entries;
+      std::ifstream in(path);
+      std::string text;
+      while (std::getline(in, text)) {
+        size_t eq = text.find(" = ");
+        if (text.empty() || text[0] == '#' || eq == std::string::npos) {
+          continue;
+        }
+        // stoi stops at the trailing comment on its own
+        entries[text.substr(0, eq)] = text.substr(eq + 3);
+      }
+      for (size_t i{0}; i < count; ++i) {
+        values[i] = std::stoi(entries[names[i]]);
+      }
+    }
+  });
+  double incanti_ns{0};
+  double allocs = allocs_per_op(rounds, [&] {
+    incanti_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        parser.parse(1, argv);
+      }
+    });
+  });
+  std::filesystem::remove(path);
+
+  record("config_file", "key = value", "lines", lines,
+         {{"naive_ms", naive_ns / 1e6},
+          {"incanti_ms", incanti_ns / 1e6},
+          {"ns_line", incanti_ns / lines},
+          {"allocs", allocs}});
+}
+
+/* parse_number() against the std::stoi / std::stod path it replaced and the
+ * strtol / strtod a getopt_long main() would use */
+void bench_conversion() {
+  std::vector<std::string> ints, doubles;
+  for (int i{0}; i < 1024; ++i) {
+    ints.push_back(std::to_string(i * 7919 - 400000));
+    doubles.push_back(std::to_string(i * 0.37 - 120.5));
+  }
+  const size_t rounds = 2000;
+  const size_t ops = rounds * ints.size();
+
+  double stoi_ns = ns_per_op(ops, [&] {
+    long acc{0};
+    for (size_t r{0}; r < rounds; ++r) {
+      for (const auto &s : ints) {
+        acc += std::stoi(s);
+      }
+    }
+    sink = static_cast<std::uint64_t>(acc);
+  });
+  double strtol_ns = ns_per_op(ops, [&] {
+    long acc{0};
+    for (size_t r{0}; r < rounds; ++r) {
+      for (const auto &s : ints) {
+        acc += std::strtol(s.c_str(), nullptr, 10);
+      }
+    }
+    sink = static_cast<std::uint64_t>(acc);
+  });
+  double int_ns = ns_per_op(ops, [&] {
+    long acc{0};
+    for (size_t r{0}; r < rounds; ++r) {
+      for (const auto &s : ints) {
+        int v{0};
+        Incanti::parse_number(s, v);
+        acc += v;
+      }
+    }
+    sink = static_cast<std::uint64_t>(acc);
+  });
+  record("conversion", "int", "values", ints.size(),
+         {{"std_ns", stoi_ns},
+          {"strto_ns", strtol_ns},
+          {"incanti_ns", int_ns}});
+
+  double stod_ns = ns_per_op(ops, [&] {
+    double acc{0};
+    for (size_t r{0}; r < rounds; ++r) {
+      for (const auto &s : doubles) {
+        acc += std::stod(s);
+      }
+    }
+    sink = static_cast<std::uint64_t>(acc);
+  });
+  double strtod_ns = ns_per_op(ops, [&] {
+    double acc{0};
+    for (size_t r{0}; r < rounds; ++r) {
+      for (const auto &s : doubles) {
+        acc += std::strtod(s.c_str(), nullptr);
+      }
+    }
+    sink = static_cast<std::uint64_t>(acc);
+  });
+  double double_ns = ns_per_op(ops, [&] {
+    double acc{0};
+    for (size_t r{0}; r < rounds; ++r) {
+      for (const auto &s : doubles) {
+        double v{0};
+        Incanti::parse_number(s, v);
+        acc += v;
+      }
+    }
+    sink = static_cast<std::uint64_t>(acc);
+  });
+  record("conversion", "double", "values", doubles.size(),
+         {{"std_ns", stod_ns},
+          {"strto_ns", strtod_ns},
+          {"incanti_ns", double_ns}});
+}
+
+/* the size, duration and CPU list converters a service writes by hand */
+std::uint64_t naive_size(const std::string &text) {
+  size_t used{0};
+  const double number = std::stod(text, &used);
+  static const std::map<std::string, double> units = {
+      {"", 1},         {"B", 1},          {"K", 1024.0},
+      {"KiB", 1024.0}, {"M", 1 << 20},    {"MiB", 1 << 20},
+      {"G", 1 << 30},  {"GiB", 1 << 30},  {"kB", 1e3},
+      {"MB", 1e6},     {"GB", 1e9}};
+  return static_cast<std::uint64_t>(number * units.at(text.substr(used)));
+}
+
+std::chrono::milliseconds naive_duration(const std::string &text) {
+  size_t used{0};
+  const double number = std::stod(text, &used);
+  const std::string unit = text.substr(used);
+  const double ms = unit == "ms"  ? 1
+                    : unit == "s" ? 1e3
+                    : unit == "m" ? 6e4
+                                  : 3.6e6;
+  return std::chrono::milliseconds(static_cast<long long>(number * ms));
+}
+
+std::vector<int> naive_cpus(const std::string &text) {
+  std::vector<int> cpus;
+  std::stringstream in(text);
+  std::string part;
+  while (std::getline(in, part, ',')) {
+    const size_t dash = part.find('-');
+    const int first = std::stoi(part.substr(0, dash));
+    const int last =
+        dash == std::string::npos ? first : std::stoi(part.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+/*
+ * the built-in ByteSize, duration and CpuSet conversions against the
+ * stod + suffix table and getline split converters they replace
+ */
+void bench_units() {
+  using Incanti::Detail::convert_value;
+  const std::vector<std::string> sizes = {"4GiB", "512K", "1.5MB", "64MiB",
+                                          "100", "2G", "750kB", "8KiB"};
+  const std::vector<std::string> durations = {"250ms", "1.5s", "30s",
+                                              "2m", "1h", "10ms"};
+  const std::vector<std::string> cpus = {"0-3,8-11", "0-63", "1,3,5,7",
+                                         "0-15,32-47", "7"};
+  const size_t rounds = 20000;
+
+  auto run = [&](const char *name, const std::vector<std::string> &inputs,
+                 auto naive, auto convert) {
+    const size_t ops = rounds * inputs.size();
+    double naive_ns = ns_per_op(ops, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        for (const auto &s : inputs) {
+          sink = naive(s);
+        }
+      }
+    });
+    double incanti_ns = ns_per_op(ops, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        for (const auto &s : inputs) {
+          sink = convert(s);
+        }
+      }
+    });
+    double allocs = allocs_per_op(inputs.size(), [&] {
+      for (const auto &s : inputs) {
+        sink = convert(s);
+      }
+    });
+    record("units", name, "values", inputs.size(),
+           {{"naive_ns", naive_ns},
+            {"incanti_ns", incanti_ns},
+            {"incanti_allocs", allocs}});
+  };
+
+  Incanti::Error error;
+  run("byte size", sizes, naive_size, [&](const std::string &s) {
+    return convert_value<Incanti::ByteSize>(s, "size", error)->bytes;
+  });
+  run(
+      "duration", durations,
+      [](const std::string &s) {
+        return static_cast<std::uint64_t>(naive_duration(s).count());
+      },
+      [&](const std::string &s) {
+        return static_cast<std::uint64_t>(
+            convert_value<std::chrono::milliseconds>(s, "timeout", error)
+                ->count());
+      });
+  run(
+      "cpu set", cpus,
+      [](const std::string &s) { return naive_cpus(s).size(); },
+      [&](const std::string &s) {
+        return convert_value<Incanti::CpuSet>(s, "cpus", error)->count();
+      });
+}
+
+/* --ids 1,2,...,N into a std::vector<int>, against a getline + stoi split */
+void bench_list() {
+  for (size_t count : {16, 1024, 50000}) {
+    std::string ids;
+    for (size_t i{0}; i < count; ++i) {
+      ids += (i ? "," : "") + std::to_string(i * 37);
+    }
+
+    std::vector<int> values;
+    Incanti::Parser parser("bench");
+    parser >> arg("ids", &values);
+    parser.seal();
+
+    std::string option = "--ids";
+    char program[] = "bench";
+    char *argv[] = {program, option.data(), ids.data()};
+
+    const size_t rounds = std::max<size_t>(1, 2000000 / count);
+    const size_t ops = rounds * count;
+
+    double naive_ns = ns_per_op(ops, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        std::vector<int> out;
+        std::istringstream in(ids);
+        std::string item;
+        while (std::getline(in, item, ',')) {
+          out.push_back(std::stoi(item));
+        }
+        sink = out.size();
+      }
+    });
+
+    double incanti_ns = ns_per_op(ops, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        parser.parse(3, argv);
+      }
+      sink = values.size();
+    });
+
+    record("list_values", "--ids a,b,c", "elements", count,
+           {{"naive_ns_el", naive_ns}, {"incanti_ns_el", incanti_ns}});
+  }
+}
+
+/* the help screen of N options: a line per option flushed with std::endl
+ * (how print_help() used to write), rendering the whole screen into one
+ * buffer, and the cached text of a sealed schema written in one go */
+void bench_help() {
+  for (size_t count : {8, 64, 512}) {
+    auto names = option_names(count);
+    std::vector<int> values(count);
+
+    auto build = [&](Incanti::Parser &parser) {
+      for (size_t i{0}; i < count; ++i) {
+        parser >> arg(names[i], &values[i]) | "help text for the option" |
+                      def(static_cast<int>(i));
+      }
+    };
+    Incanti::Parser unsealed("bench", "help rendering");
+    build(unsealed);
+    Incanti::Parser sealed("bench", "help rendering");
+    build(sealed);
+    std::shared_ptr<const Incanti::Schema> schema = sealed.share();
+
+    std::ostringstream discard;
+    const size_t rounds = std::max<size_t>(1, 20000 / count);
+    auto measure = [&](auto &&body, double &allocs) {
+      double ns{0};
+      allocs = allocs_per_op(rounds, [&] {
+        ns = ns_per_op(rounds, [&] {
+          for (size_t r{0}; r < rounds; ++r) {
+            discard.str(std::string());
+            body();
+          }
+        });
+      });
+      return ns;
+    };
+
+    double lines_allocs{0};
+    double lines_ns = measure(
+        [&] {
+          for (std::uint32_t slot{0}; slot < schema->size(); ++slot) {
+            discard << schema->argument(slot).get_help() << std::endl;
+          }
+        },
+        lines_allocs);
+
+    // an unsealed schema renders on every call
+    double render_allocs{0};
+    double render_ns = measure([&] { unsealed.print_help(discard); },
+                               render_allocs);
+
+    schema->print_help(discard); // rendered once, kept
+    double cached_allocs{0};
+    double cached_ns = measure([&] { schema->print_help(discard); },
+                               cached_allocs);
+    sink = schema->help(80).size();
+
+    record("help", "line per option", "options", count,
+           {{"us", lines_ns / 1000.0}, {"allocs", lines_allocs}});
+    record("help", "render", "options", count,
+           {{"us", render_ns / 1000.0}, {"allocs", render_allocs}});
+    record("help", "cached", "options", count,
+           {{"us", cached_ns / 1000.0}, {"allocs", cached_allocs}});
+  }
+}
+
+/* env-bound options resolved from a 200 entry environment block: one
+ * indexed pass, against a getenv-style scan per option */
+void bench_environment() {
+  for (size_t bound : {4, 16, 64}) {
+    auto names = option_names(bound);
+    std::vector<int> values(bound);
+
+    std::vector<std::string> entries;
+    for (size_t i{0}; i < 200; ++i) {
+      // half of them share the first letter with the bound names
+      entries.push_back((i % 2 ? "UNRELATED_VARIABLE_" : "BUILD_VARIABLE_") +
+                        std::to_string(i) + "=x");
+    }
+    std::vector<std::string> vars;
+    for (size_t i{0}; i < bound; ++i) {
+      vars.push_back("BENCH_OPTION_" + std::to_string(i));
+      entries.push_back(vars[i] + "=" + std::to_string(i));
+    }
+    std::vector<char *> envp;
+    for (auto &e : entries) {
+      envp.push_back(e.data());
+    }
+    envp.push_back(nullptr);
+
+    Incanti::Parser parser("bench");
+    for (size_t i{0}; i < bound; ++i) {
+      parser >> arg(names[i], &values[i]) | env(vars[i]);
+    }
+    parser.environment(envp.data());
+    parser.seal();
+    char program[] = "bench";
+    char *argv[] = {program, nullptr};
+
+    const size_t rounds = 20000;
+    double scan_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        for (size_t i{0}; i < bound; ++i) {
+          const std::string &var = vars[i];
+          for (char **e = envp.data(); *e; ++e) {
+            if (std::strncmp(*e, var.c_str(), var.size()) == 0 &&
+                (*e)[var.size()] == '=') {
+              values[i] = static_cast<int>(
+                  std::strtol(*e + var.size() + 1, nullptr, 10));
+              break;
+            }
+          }
+        }
+      }
+    });
+    double incanti_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        parser.parse(1, argv);
+      }
+    });
+    record("environment", "200 entries", "bound", bound,
+           {{"getenv_ns", scan_ns}, {"incanti_ns", incanti_ns}});
+  }
+}
+
+struct HelperOptions {
+  std::string input;
+  std::string output;
+  int threads{0};
+  double threshold{0.0};
+  bool verbose{false};
+  bool force{false};
+};
+
+constexpr auto helper_cli = Incanti::struct_parser(
+    field("input", "i", &HelperOptions::input) | required,
+    field("output", "o", &HelperOptions::output),
+    field("threads", "t", &HelperOptions::threads) | def(4),
+    field("threshold", &HelperOptions::threshold) | def(0.5),
+    field("verbose", "v", &HelperOptions::verbose),
+    field("force", "f", &HelperOptions::force));
+
+/* what a short-lived helper pays from process start to parsed options:
+ * a runtime Parser built and filled, against the constexpr struct parser */
+void bench_startup() {
+  const char *tokens[] = {"bench", "-i", "in.bin", "-o", "out.bin",
+                          "-t8",   "-vf", nullptr};
+  const int argc = static_cast<int>(sizeof(tokens) / sizeof(tokens[0])) - 1;
+  auto argv = const_cast<char **>(tokens);
+
+  const size_t rounds = 100000;
+  double runtime_ns{0};
+  double runtime_allocs = allocs_per_op(rounds, [&] {
+    runtime_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        HelperOptions o;
+        Incanti::Parser parser("bench");
+        parser >> arg("input", "i", &o.input) | required;
+        parser >> arg("output", "o", &o.output);
+        parser >> arg("threads", "t", &o.threads) | def(4);
+        parser >> arg("threshold", &o.threshold) | def(0.5);
+        parser >> flag("verbose", "v", &o.verbose);
+        parser >> flag("force", "f", &o.force);
+        parser.parse(argc, argv);
+        sink = static_cast<std::uint64_t>(o.threads);
+      }
+    });
+  });
+
+  double struct_ns{0};
+  double struct_allocs = allocs_per_op(rounds, [&] {
+    struct_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        HelperOptions o = helper_cli.parse(argc, argv);
+        sink = static_cast<std::uint64_t>(o.threads);
+      }
+    });
+  });
+
+  record("startup", "Parser", "tokens", static_cast<size_t>(argc - 1),
+         {{"ns", runtime_ns}, {"allocs", runtime_allocs}});
+  record("startup", "struct_parser", "tokens", static_cast<size_t>(argc - 1),
+         {{"ns", struct_ns}, {"allocs", struct_allocs}});
+}
+
+/* command lines of a job service, with the --threads each one asks for */
+const char *const service_requests[] = {
+    "-i /srv/in/a.bin -o /srv/out/a.bin -t8 -v",
+    "--input \"/srv/in/with space.bin\" --threshold 0.25",
+    "-i '/srv/in/b.bin' --output=/srv/out/b.bin -vf",
+    "--input=/srv/in/c.bin -t 16 --threshold=0.9 extra.txt"};
+const int service_threads[] = {8, 4, 4, 16};
+
+void add_service_options(Incanti::Parser &parser, HelperOptions &o) {
+  parser >> arg("input", "i", &o.input) | required;
+  parser >> arg("output", "o", &o.output);
+  parser >> arg("threads", "t", &o.threads) | def(4);
+  parser >> arg("threshold", &o.threshold) | def(0.5);
+  parser >> flag("verbose", "v", &o.verbose);
+  parser >> flag("force", "f", &o.force);
+}
+
+/* a server handling one command line string per request: a warm parser
+ * reset() and re-parsed against a parser built for every request */
+void bench_command_stream() {
+  const auto &requests = service_requests;
+  const size_t kinds = sizeof(requests) / sizeof(requests[0]);
+
+  const size_t rounds = 100000;
+  HelperOptions o;
+  Incanti::Parser parser("bench");
+  add_service_options(parser, o);
+  parser.seal();
+  for (const char *request : requests) {
+    parser.parse(std::string_view(request)); // warm the buffers
+  }
+  // a --help request is answered by the service, the process goes on
+  parser.parse(std::string_view("-i /srv/in/a.bin --help"));
+  const bool asked = parser.help_requested();
+  parser.parse(std::string_view(requests[0]));
+  if (!asked || parser.help_requested()) {
+    std::cerr << "command_stream: --help not reported\n";
+    std::abort();
+  }
+
+  double warm_ns{0};
+  double warm_allocs = allocs_per_op(rounds, [&] {
+    warm_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        parser.reset();
+        parser.parse(std::string_view(requests[r % kinds]));
+        sink = static_cast<std::uint64_t>(o.threads);
+      }
+    });
+  });
+
+  double fresh_ns{0};
+  double fresh_allocs = allocs_per_op(rounds, [&] {
+    fresh_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        HelperOptions fresh;
+        Incanti::Parser p("bench");
+        add_service_options(p, fresh);
+        p.parse(std::string_view(requests[r % kinds]));
+        sink = static_cast<std::uint64_t>(fresh.threads);
+      }
+    });
+  });
+
+  record("command_stream", "reset + parse", "requests", kinds,
+         {{"parses_per_s", 1e9 / warm_ns}, {"allocs", warm_allocs}});
+  record("command_stream", "new Parser", "requests", kinds,
+         {{"parses_per_s", 1e9 / fresh_ns}, {"allocs", fresh_allocs}});
+}
+
+/* threads validating requests against one shared Schema with a
+ * ParseResult each, against a Parser per thread built under a mutex.
+ * Every result is checked, so a ThreadSanitizer build (INCANTI_TSAN)
+ * doubles as a stress test of the shared schema. */
+void bench_shared_schema() {
+  const size_t kinds = sizeof(service_requests) / sizeof(service_requests[0]);
+  const size_t rounds = 20000; // per thread
+
+  HelperOptions unused;
+  Incanti::Parser builder("bench");
+  add_service_options(builder, unused);
+  std::shared_ptr<const Incanti::Schema> schema = builder.share();
+
+  std::atomic<size_t> wrong{0};
+  auto check = [&](int threads, size_t r) {
+    if (threads != service_threads[r % kinds]) {
+      wrong.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+  auto run = [](size_t threads, auto &&body) {
+    std::vector<std::thread> pool;
+    return ns_per_op(threads * rounds, [&] {
+      for (size_t t{0}; t < threads; ++t) {
+        pool.emplace_back(body, t);
+      }
+      for (auto &thread : pool) {
+        thread.join();
+      }
+    });
+  };
+
+  std::mutex construction;
+  for (size_t threads : {1, 2, 4, 8}) {
+    double shared_ns = run(threads, [&](size_t t) {
+      Incanti::ParseResult result(schema);
+      for (size_t r{t}; r < t + rounds; ++r) {
+        schema->parse(service_requests[r % kinds], result);
+        check(result.get<int>("threads"), r);
+      }
+    });
+
+    double owned_ns = run(threads, [&](size_t t) {
+      HelperOptions o;
+      std::unique_lock<std::mutex> lock(construction);
+      Incanti::Parser parser("bench");
+      add_service_options(parser, o);
+      parser.seal();
+      lock.unlock();
+      for (size_t r{t}; r < t + rounds; ++r) {
+        parser.reset();
+        parser.parse(std::string_view(service_requests[r % kinds]));
+        check(o.threads, r);
+      }
+    });
+
+    record("shared_schema", "Schema + ParseResult", "threads", threads,
+           {{"parses_per_s", 1e9 / shared_ns}});
+    record("shared_schema", "Parser per thread", "threads", threads,
+           {{"parses_per_s", 1e9 / owned_ns}});
+  }
+
+  if (wrong.load() != 0) {
+    std::cerr << "shared_schema: " << wrong.load() << " wrong results\n";
+    std::abort();
+  }
+}
+
+/* a scheduler validating a queue of job command lines: parse_batch()
+ * over 1..N pool threads against a serial loop reusing one result */
+void bench_batch() {
+  const size_t count = 200000;
+  const size_t kinds = sizeof(service_requests) / sizeof(service_requests[0]);
+  std::vector<std::string> lines;
+  lines.reserve(count);
+  for (size_t i{0}; i < count; ++i) {
+    lines.push_back(std::string(service_requests[i % kinds]) + " --output " +
+                    "/srv/out/job-" + std::to_string(i));
+  }
+
+  HelperOptions unused;
+  Incanti::Parser builder("bench");
+  add_service_options(builder, unused);
+  std::shared_ptr<const Incanti::Schema> schema = builder.share();
+
+  Incanti::ParseResult result(schema);
+  double serial_ns = ns_per_op(count, [&] {
+    for (const std::string &line : lines) {
+      schema->parse(line, result);
+      sink = static_cast<std::uint64_t>(result.get<int>("threads"));
+    }
+  });
+  record("batch", "serial loop", "threads", 1,
+         {{"lines_per_s", 1e9 / serial_ns}, {"speedup", 1.0}});
+
+  const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<size_t> sizes{1, 2, 4, 8};
+  for (size_t n{16}; n <= cores; n *= 2) {
+    sizes.push_back(n);
+  }
+  double single_ns{0};
+  for (size_t threads : sizes) {
+    Incanti::WorkerPool pool(threads);
+    size_t failed{0};
+    double ns = ns_per_op(count, [&] {
+      auto results = schema->parse_batch(lines, pool);
+      for (const auto &item : results) {
+        failed += !item.ok();
+      }
+    });
+    if (failed != 0) {
+      std::cerr << "batch: " << failed << " lines failed\n";
+      std::abort();
+    }
+    single_ns = threads == 1 ? ns : single_ns;
+    record("batch", "parse_batch", "threads", threads,
+           {{"lines_per_s", 1e9 / ns}, {"speedup", single_ns / ns}});
+  }
+}
+
+/* `prog __complete` queries against a 300 option schema: the first query
+ * (which sorts the index), warm option and value prefixes, and the whole
+ * round trip of starting this binary in completion mode */
+void bench_completion() {
+  const size_t count = 300;
+  auto names = option_names(count);
+  std::vector<std::string> values(count);
+
+  Incanti::Parser parser("bench");
+  for (size_t i{0}; i < count; ++i) {
+    auto &a = parser >> arg(names[i], &values[i]);
+    if (i % 10 == 0) {
+      a | choices("fast", "slow", "balanced", "fastest", "off");
+    }
+  }
+  parser.seal();
+
+  struct Query {
+    const char *name;
+    std::vector<std::string> words;
+  };
+  std::vector<Query> queries = {
+      {"--option-name-1", {"-i", "x", "--option-name-1"}},
+      {"--opt (all)", {"--opt"}},
+      {"value prefix", {"--option-name-10", "fa"}},
+      {"--name=value", {"--option-name-20=s"}}};
+
+  std::string out;
+  for (Query &q : queries) {
+    std::vector<char *> words;
+    for (std::string &w : q.words) {
+      words.push_back(w.data());
+    }
+    const int n = static_cast<int>(words.size());
+    size_t found{0};
+    const size_t rounds = 20000;
+    double ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        out.clear();
+        found = parser.complete(n, words.data(), out);
+      }
+    });
+    record("completion", q.name, "options", count,
+           {{"ns_per_query", ns}, {"candidates", static_cast<double>(found)}});
+  }
+
+  // the first query of a fresh process builds the sorted index
+  double first_ns{0};
+  {
+    Incanti::Parser fresh("bench");
+    for (size_t i{0}; i < count; ++i) {
+      fresh >> arg(names[i], &values[i]);
+    }
+    fresh.seal();
+    std::string word = "--option-name-2";
+    char *words[] = {word.data()};
+    out.clear();
+    first_ns = ns_per_op(1, [&] { fresh.complete(1, words, out); });
+  }
+  record("completion", "first query", "options", count,
+         {{"ns_per_query", first_ns}});
+
+#if defined(__linux__)
+  // start, answer and exit: what the shell waits for on <TAB>
+  char self[] = "/proc/self/exe";
+  char mode[] = "__complete";
+  char prefix[] = "--f";
+  char *argv[] = {self, mode, prefix, nullptr};
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+  const size_t rounds = 50;
+  size_t failed{0};
+  double spawn_ns = ns_per_op(rounds, [&] {
+    for (size_t r{0}; r < rounds; ++r) {
+      pid_t pid{0};
+      int status{0};
+      if (posix_spawn(&pid, self, &actions, nullptr, argv, environ) != 0 ||
+          waitpid(pid, &status, 0) != pid || status != 0) {
+        ++failed;
+      }
+    }
+  });
+  posix_spawn_file_actions_destroy(&actions);
+  if (failed == 0) {
+    record("completion", "process round trip", "options", 2,
+           {{"ns_per_query", spawn_ns}});
+  }
+#endif
+}
+
+/* rejecting bad command lines: parse() throwing a ParseError against
+ * try_parse() handing back the Error, on a warm parser; only the latter
+ * in -fno-exceptions builds */
+void bench_errors() {
+  const char *const bad[] = {
+      "-i /srv/in/a.bin --threds 8",          // unknown option
+      "-i /srv/in/a.bin -t 8x",               // trailing characters
+      "--input /srv/in/a.bin --threshold",    // missing value
+      "-o /srv/out/a.bin -t 4",               // missing required option
+  };
+  const size_t kinds = sizeof(bad) / sizeof(bad[0]);
+  const size_t rounds = 200000;
+
+  HelperOptions o;
+  Incanti::Parser parser("bench");
+  add_service_options(parser, o);
+  parser.seal();
+
+  size_t rejected{0};
+  size_t runs{0};
+#if INCANTI_EXCEPTIONS
+  auto throwing = [&] {
+    for (size_t r{0}; r < rounds; ++r) {
+      try {
+        parser.parse(std::string_view(bad[r % kinds]));
+      } catch (const Incanti::ParseError &e) {
+        rejected += e.error().code != Incanti::ErrorCode::none;
+      }
+    }
+  };
+  throwing();
+  double throw_allocs = allocs_per_op(rounds, throwing);
+  double throw_ns = ns_per_op(rounds, throwing);
+  runs += 3;
+#endif
+  auto expected = [&] {
+    for (size_t r{0}; r < rounds; ++r) {
+      auto parsed = parser.try_parse(std::string_view(bad[r % kinds]));
+      rejected += !parsed;
+    }
+  };
+  expected();
+  double try_allocs = allocs_per_op(rounds, expected);
+  double try_ns = ns_per_op(rounds, expected);
+  runs += 3;
+  if (rejected != rounds * runs) {
+    std::cerr << "errors: " << rounds * runs - rejected
+              << " bad lines were accepted\n";
+    std::abort();
+  }
+
+#if INCANTI_EXCEPTIONS
+  record("errors", "parse() + catch", "lines", kinds,
+         {{"ns_per_line", throw_ns}, {"allocs", throw_allocs}});
+#endif
+  record("errors", "try_parse()", "lines", kinds,
+         {{"ns_per_line", try_ns}, {"allocs", try_allocs}});
+}
+
+/*
+ * start up of a git style tool: register everything, then parse one verb.
+ * Flat registers every verb's options on one parser; with command() only
+ * the verb given has its options registered.
+ */
+void bench_commands() {
+  const size_t per_verb = 16;
+  for (size_t verbs : {8, 64, 256}) {
+    auto names = option_names(per_verb);
+    std::vector<std::string> verb_names;
+    std::vector<std::string> flat_names;
+    for (size_t v{0}; v < verbs; ++v) {
+      verb_names.push_back("verb-" + std::to_string(v));
+      for (size_t i{0}; i < per_verb; ++i) {
+        flat_names.push_back(verb_names.back() + "-" + names[i]);
+      }
+    }
+    std::vector<int> values(verbs * per_verb);
+    bool verbose{false};
+
+    const std::string verb = verb_names[verbs / 2];
+    CommandLine flat_line;
+    flat_line.push("-v");
+    flat_line.push("--" + verb + "-" + names[3]);
+    flat_line.push("5");
+    CommandLine lazy_line;
+    lazy_line.push("-v");
+    lazy_line.push(verb);
+    lazy_line.push("--" + names[3]);
+    lazy_line.push("5");
+
+    const size_t rounds = std::max<size_t>(1, 40000 / verbs);
+    auto flat = [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        Incanti::Parser parser("tool");
+        parser >> flag("verbose", "v", &verbose);
+        for (size_t i{0}; i < flat_names.size(); ++i) {
+          parser >> arg(flat_names[i], &values[i]) | "help text for the option";
+        }
+        parser.parse(flat_line.argc(), flat_line.data());
+      }
+    };
+    auto lazy = [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        Incanti::Parser parser("tool");
+        parser >> flag("verbose", "v", &verbose);
+        for (size_t v{0}; v < verbs; ++v) {
+          int *bound = &values[v * per_verb];
+          parser.command(verb_names[v], "help text for the verb",
+                         [&names, bound](Incanti::Parser &sub) {
+                           for (size_t i{0}; i < names.size(); ++i) {
+                             sub >> arg(names[i], bound + i) |
+                                        "help text for the option";
+                           }
+                         });
+        }
+        parser.parse(lazy_line.argc(), lazy_line.data());
+      }
+    };
+
+    double flat_ns{0}, lazy_ns{0};
+    double flat_allocs =
+        allocs_per_op(rounds, [&] { flat_ns = ns_per_op(rounds, flat); });
+    double lazy_allocs =
+        allocs_per_op(rounds, [&] { lazy_ns = ns_per_op(rounds, lazy); });
+    if (values[verbs / 2 * per_verb + 3] != 5 || !verbose) {
+      std::cerr << "commands: the verb's option was not set\n";
+      std::abort();
+    }
+
+    record("commands", "flat", "verbs", verbs,
+           {{"us", flat_ns / 1000.0}, {"allocs", flat_allocs}});
+    record("commands", "command()", "verbs", verbs,
+           {{"us", lazy_ns / 1000.0}, {"allocs", lazy_allocs}});
+  }
+}
+
+/*
+ * "did you mean" for a mistyped option, against the number of registered
+ * names: the BK-tree search try_parse() does, and a scan of every name
+ */
+void bench_suggestions() {
+  // names made of syllables, as unlike each other as real option names
+  const char *const syllables[] = {"ba", "con", "de", "fil", "gra", "hex",
+                                   "lo",  "mi",  "nor", "pe", "qua", "re",
+                                   "sil", "tor", "ul",  "ver", "wy",  "zen"};
+  std::vector<std::string> words;
+  std::uint32_t seed{12345};
+  auto syllable = [&] {
+    seed = seed * 1664525u + 1013904223u;
+    return syllables[(seed >> 16) % (sizeof(syllables) / sizeof(char *))];
+  };
+  std::set<std::string> seen;
+  while (words.size() < 4096) {
+    std::string word = std::string(syllable()) + syllable() + "-" +
+                       syllable() + syllable();
+    if (seen.insert(word).second) {
+      words.push_back(word);
+    }
+  }
+
+  for (size_t count : {32, 512, 4096}) {
+    std::vector<std::string> names(words.begin(), words.begin() + count);
+    std::vector<int> values(count);
+    Incanti::Parser parser("bench");
+    for (size_t i{0}; i < count; ++i) {
+      parser >> arg(names[i], &values[i]);
+    }
+    parser.seal();
+
+    // one typo each: a swap, a drop and a wrong character
+    std::string name = names[count / 3];
+    std::string swapped = name;
+    std::swap(swapped[2], swapped[3]);
+    const std::string typos[] = {
+        "--" + swapped, "--" + name.substr(0, 8) + name.substr(9),
+        "--" + name.substr(0, 5) + "x" + name.substr(6)};
+    const size_t kinds = sizeof(typos) / sizeof(typos[0]);
+    const size_t rounds = std::max<size_t>(30, 30000 / count);
+
+    size_t found{0};
+    parser.try_parse(std::string_view(typos[0])); // builds the trees
+    double tree_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        auto parsed = parser.try_parse(std::string_view(typos[r % kinds]));
+        found += !parsed && !parsed.error().suggestions.empty();
+      }
+    });
+    double scan_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        std::string_view typo = typos[r % kinds];
+        Incanti::Detail::NearMatches near(typo.substr(2));
+        for (const std::string &candidate : names) {
+          near.offer("--", candidate);
+        }
+        Incanti::Error error;
+        near.report(error);
+        found += !error.suggestions.empty();
+      }
+    });
+    if (found != rounds * 2) {
+      std::cerr << "suggestions: " << rounds * 2 - found
+                << " typos got no suggestion\n";
+      std::abort();
+    }
+
+    record("suggestions", "try_parse() (tree)", "names", count,
+           {{"us_per_typo", tree_ns / 1000.0}});
+    record("suggestions", "scan every name", "names", count,
+           {{"us_per_typo", scan_ns / 1000.0}});
+  }
+}
+
+/*
+ * xargs style lines of paths: collected and then read as positional()
+ * strings, collected as views, and streamed to on_positional(). On Linux
+ * the same paths also come NUL separated from standard input ("-").
+ */
+void bench_positionals() {
+  for (size_t count : {1000, 100000}) {
+    CommandLine line;
+    line.push("--verbose");
+    for (size_t i{0}; i < count; ++i) {
+      line.push("/srv/data/shard-" + std::to_string(i % 64) + "/file-" +
+                std::to_string(i) + ".bin");
+    }
+    char **argv = line.data();
+    const size_t rounds = std::max<size_t>(5, 200000 / count);
+
+    bool verbose{false};
+    Incanti::Parser parser("bench");
+    parser >> flag("verbose", "v", &verbose);
+    parser.seal();
+    parser.parse(line.argc(), argv); // warm the positional storage
+
+    size_t bytes{0};
+    double strings_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        parser.parse(line.argc(), argv);
+        for (const std::string &path : parser.positional()) {
+          bytes += path.size();
+        }
+      }
+    });
+    double views_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        parser.parse(line.argc(), argv);
+        for (std::string_view path : parser.positional_views()) {
+          bytes += path.size();
+        }
+      }
+    });
+    parser.on_positional([&](std::string_view path) { bytes += path.size(); });
+    double stream_ns{0};
+    double stream_allocs = allocs_per_op(rounds, [&] {
+      stream_ns = ns_per_op(rounds, [&] {
+        for (size_t r{0}; r < rounds; ++r) {
+          parser.parse(line.argc(), argv);
+        }
+      });
+    });
+    Metrics metrics{{"strings_us", strings_ns / 1000.0},
+                    {"views_us", views_ns / 1000.0},
+                    {"callback_us", stream_ns / 1000.0},
+                    {"callback_allocs", stream_allocs}};
+
+#if defined(__linux__)
+    auto path = (std::filesystem::temp_directory_path() /
+                 "incanti_bench.paths")
+                    .string();
+    {
+      std::ofstream out(path, std::ios::binary);
+      for (int i{2}; i < line.argc(); ++i) {
+        out << line.tokens[static_cast<size_t>(i)] << '\0';
+      }
+    }
+    const int saved = ::dup(STDIN_FILENO);
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    ::dup2(fd, STDIN_FILENO);
+    ::close(fd);
+    parser.positional_stdin();
+    char program[] = "bench";
+    char dash[] = "-";
+    char *stdin_argv[] = {program, dash, nullptr};
+    double stdin_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        ::lseek(STDIN_FILENO, 0, SEEK_SET);
+        parser.parse(2, stdin_argv);
+      }
+    });
+    ::dup2(saved, STDIN_FILENO);
+    ::close(saved);
+    std::filesystem::remove(path);
+    metrics.push_back({"stdin_us", stdin_ns / 1000.0});
+#endif
+    sink = bytes;
+
+    record("positionals", "paths", "paths", count, std::move(metrics));
+  }
+}
+
+/* a value with a costly converter: a few hundred numbers in one option */
+struct Samples {
+  std::vector<long> values;
+};
+
+Samples parse_samples(std::string_view text) {
+  Samples samples;
+  while (!text.empty()) {
+    const size_t comma = std::min(text.find(','), text.size());
+    long value{0};
+    Incanti::parse_number(text.substr(0, comma), value);
+    samples.values.push_back(value);
+    text.remove_prefix(std::min(comma + 1, text.size()));
+  }
+  return samples;
+}
+
+/*
+ * options with an expensive converter, all given on the command line and
+ * one of them read: converted during parse(), against Lazy<T> converting
+ * the one read. Reading every Lazy shows what deferring itself costs.
+ */
+void bench_lazy() {
+  std::string list;
+  for (int i{0}; i < 256; ++i) {
+    list.append(i ? "," : "").append(std::to_string(i * 7919));
+  }
+  for (size_t count : {4, 16, 64}) {
+    std::vector<std::string> names = option_names(count);
+    CommandLine line;
+    for (const std::string &name : names) {
+      line.push("--" + name);
+      line.push(list);
+    }
+    char **argv = line.data();
+    const size_t rounds = std::max<size_t>(50, 20000 / count);
+
+    std::vector<Samples> eager(count);
+    Incanti::Parser eager_parser("bench");
+    for (size_t i{0}; i < count; ++i) {
+      eager_parser >> arg(names[i], &eager[i]) | parse_samples;
+    }
+    eager_parser.seal();
+
+    std::vector<Incanti::Lazy<Samples>> lazy(count);
+    Incanti::Parser lazy_parser("bench");
+    for (size_t i{0}; i < count; ++i) {
+      lazy_parser >> arg(names[i], &lazy[i]) | parse_samples;
+    }
+    lazy_parser.seal();
+
+    double eager_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        eager_parser.parse(line.argc(), argv);
+        sink = eager[r % count].values.size();
+      }
+    });
+    double lazy_one_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        lazy_parser.parse(line.argc(), argv);
+        sink = lazy[r % count]->values.size();
+      }
+    });
+    double lazy_all_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        lazy_parser.parse(line.argc(), argv);
+        for (const auto &value : lazy) {
+          sink = value->values.size();
+        }
+      }
+    });
+    record("lazy", "parse + read", "options", count,
+           {{"eager_us", eager_ns / 1000.0},
+            {"lazy_one_us", lazy_one_ns / 1000.0},
+            {"lazy_all_us", lazy_all_ns / 1000.0}});
+  }
+}
+
+/*
+ * ConfigWatcher::reload() of a file where nothing or one key changed,
+ * against parsing the whole file again, and the cost of reading a
+ * Reloadable while another thread keeps replacing it
+ */
+void bench_reload() {
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "incanti_reload.toml")
+          .string();
+  auto write = [&](size_t count, int changed) {
+    std::ofstream out(path);
+    for (size_t i{0}; i < count; ++i) {
+      out << "option-name-" << i << " = "
+          << (i == 0 ? changed : static_cast<int>(i)) << "\n";
+    }
+  };
+
+  for (size_t count : {16, 256}) {
+    std::vector<std::string> names = option_names(count);
+    std::vector<Incanti::Reloadable<int>> values(count);
+    Incanti::Parser parser("bench");
+    for (size_t i{0}; i < count; ++i) {
+      parser >> arg(names[i], &values[i]);
+    }
+    parser.config_file(path);
+    write(count, 0);
+    char program[] = "bench";
+    char *argv[] = {program, nullptr};
+    parser.parse(1, argv);
+    Incanti::ConfigWatcher watcher(parser);
+
+    const size_t rounds = 2000;
+    double parse_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        parser.parse(1, argv);
+      }
+    });
+    double same_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        sink = *watcher.reload();
+      }
+    });
+    double changed_ns{0};
+    for (size_t r{0}; r < rounds; ++r) {
+      write(count, static_cast<int>(r) + 1);
+      changed_ns += ns_per_op(1, [&] { sink = *watcher.reload(); });
+    }
+    record("reload", "key = value", "options", count,
+           {{"parse_us", parse_ns / 1000.0},
+            {"same_us", same_ns / 1000.0},
+            {"one_changed_us", changed_ns / rounds / 1000.0}});
+  }
+  std::filesystem::remove(path);
+
+  auto readers = [](const char *name, auto &value, auto next, auto read) {
+    const size_t rounds = 2000000;
+    double idle_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        sink = read(value);
+      }
+    });
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+      for (int i{0}; !done.load(std::memory_order_relaxed); ++i) {
+        value.store(next(i));
+      }
+    });
+    double busy_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        sink = read(value);
+      }
+    });
+    done = true;
+    writer.join();
+    record("reload", name, "threads", 2,
+           {{"read_ns", idle_ns}, {"read_reloading_ns", busy_ns}});
+  };
+  Incanti::Reloadable<int> level{0};
+  readers(
+      "int load()", level, [](int i) { return i; },
+      [](const auto &v) { return static_cast<std::uint64_t>(v.load()); });
+  Incanti::Reloadable<std::string> endpoint{"http://localhost:8080"};
+  readers(
+      "string snapshot", endpoint,
+      [](int i) { return "http://localhost:" + std::to_string(8000 + i); },
+      [](const auto &v) { return v.snapshot()->size(); });
+}
+
+/* heap allocations per parse() of a typical command line, after the schema
+ * is built and the bound strings are warm. Expected to be zero. */
+void bench_allocations() {
+  std::string input, output, mode;
+  int threads{0};
+  double threshold{0.0};
+  float scale{0.0f};
+  bool verbose{false}, debug{false}, force{false};
+
+  Incanti::Parser parser("bench", "allocation check");
+  parser >> arg("input", "i", &input) | required;
+  parser >> arg("output", "o", &output) | def("output.txt");
+  parser >> arg("mode", "m", &mode) | def("balanced");
+  parser >> arg("threads", "th", &threads) | def(4);
+  parser >> arg("threshold", &threshold) | def(0.5);
+  parser >> arg("scale", "s", &scale) | def(1.0f);
+  parser >> flag("verbose", "v", &verbose);
+  parser >> flag("debug", "d", &debug);
+  parser >> flag("force", "f", &force);
+  parser.seal();
+
+  const char *tokens[] = {"bench",
+                          "--input=/var/lib/jobs/input-data.bin",
+                          "-o",
+                          "/var/lib/jobs/output-data.bin",
+                          "--mode",
+                          "fast",
+                          "-th8",
+                          "--threshold",
+                          "0.75",
+                          "-s",
+                          "2.5",
+                          "-vdf",
+                          nullptr};
+  const int argc = static_cast<int>(sizeof(tokens) / sizeof(tokens[0])) - 1;
+  auto argv = const_cast<char **>(tokens);
+
+  parser.parse(argc, argv); // warm the bound strings
+
+  const size_t rounds = 100000;
+  double ns{0};
+  double allocs = allocs_per_op(rounds, [&] {
+    ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        parser.parse(argc, argv);
+      }
+    });
+  });
+  if (allocs != 0) {
+    std::cerr << "allocations: " << allocs << " per parse, expected 0\n";
+    std::abort();
+  }
+  Metrics metrics{{"incanti_ns", ns}, {"incanti_allocs", allocs}};
+
+#if INCANTI_BENCH_GETOPT
+  const option longs[] = {{"input", required_argument, nullptr, 'i'},
+                          {"output", required_argument, nullptr, 'o'},
+                          {"mode", required_argument, nullptr, 'm'},
+                          {"threads", required_argument, nullptr, 't'},
+                          {"threshold", required_argument, nullptr, 'T'},
+                          {"scale", required_argument, nullptr, 's'},
+                          {"verbose", no_argument, nullptr, 'v'},
+                          {"debug", no_argument, nullptr, 'd'},
+                          {"force", no_argument, nullptr, 'f'},
+                          {nullptr, 0, nullptr, 0}};
+  // getopt has no two letter short options, -th8 is spelled -t8 for it
+  std::vector<char *> getopt_argv(argv, argv + argc + 1);
+  std::string threads_token = "-t8";
+  getopt_argv[6] = threads_token.data();
+
+  auto on_option = [&](int c) {
+    switch (c) {
+    case 'i':
+      input = optarg;
+      break;
+    case 'o':
+      output = optarg;
+      break;
+    case 'm':
+      mode = optarg;
+      break;
+    case 't':
+      threads = static_cast<int>(std::strtol(optarg, nullptr, 10));
+      break;
+    case 'T':
+      threshold = std::strtod(optarg, nullptr);
+      break;
+    case 's':
+      scale = std::strtof(optarg, nullptr);
+      break;
+    case 'v':
+      verbose = true;
+      break;
+    case 'd':
+      debug = true;
+      break;
+    case 'f':
+      force = true;
+      break;
+    }
+  };
+  double getopt_ns{0};
+  double getopt_allocs = allocs_per_op(rounds, [&] {
+    getopt_ns = ns_per_op(rounds, [&] {
+      for (size_t r{0}; r < rounds; ++r) {
+        getopt_parse(argc, getopt_argv.data(), "i:o:m:t:s:vdf", longs,
+                     on_option);
+      }
+    });
+  });
+  metrics.push_back({"getopt_ns", getopt_ns});
+  metrics.push_back({"getopt_allocs", getopt_allocs});
+#endif
+
+  record("allocations", "demo line", "tokens", static_cast<size_t>(argc - 1),
+         std::move(metrics));
+}
+
+/* what Parser::stats() reports for the allocations demo line, and the
+ * cost of a parse with it; compare against a build without INCANTI_STATS */
+void bench_stats() {
+  std::string input, output;
+  int threads{0};
+  double threshold{0.0};
+  bool verbose{false}, debug{false}, force{false};
+
+  Incanti::Parser parser("bench", "stats check");
+  parser >> arg("input", "i", &input) | required;
+  parser >> arg("output", "o", &output) | def("output.txt");
+  parser >> arg("threads", "th", &threads) | def(4);
+  parser >> arg("threshold", &threshold) | def(0.5);
+  parser >> flag("verbose", "v", &verbose);
+  parser >> flag("debug", "d", &debug);
+  parser >> flag("force", "f", &force);
+  parser.seal();
+
+  const char *tokens[] = {"bench",       "--input=/var/lib/jobs/input.bin",
+                          "-o",          "/var/lib/jobs/output.bin",
+                          "-th8",        "--threshold",
+                          "0.75",        "-vdf",
+                          nullptr};
+  const int argc = static_cast<int>(sizeof(tokens) / sizeof(tokens[0])) - 1;
+  auto argv = const_cast<char **>(tokens);
+
+  parser.parse(argc, argv); // warm the bound strings
+  parser.reset_stats();
+
+  const size_t rounds = 100000;
+  double ns = ns_per_op(rounds, [&] {
+    for (size_t r{0}; r < rounds; ++r) {
+      parser.parse(argc, argv);
+    }
+  });
+  Metrics metrics{{"parse_ns", ns}};
+
+  if (Incanti::Stats::enabled) {
+    const Incanti::Stats stats = parser.stats();
+    const double parses = static_cast<double>(stats.parses);
+    std::uint64_t convert_ns{0};
+    for (const auto &option : stats.options) {
+      convert_ns += option.convert_ns;
+    }
+    metrics.push_back(
+        {"stats_parse_ns", static_cast<double>(stats.parse_ns) / parses});
+    metrics.push_back(
+        {"convert_ns", static_cast<double>(convert_ns) / parses});
+    metrics.push_back({"tokens", static_cast<double>(stats.tokens) / parses});
+    metrics.push_back(
+        {"lookups", static_cast<double>(stats.lookups) / parses});
+    metrics.push_back(
+        {"allocs", static_cast<double>(stats.allocations) / parses});
+  }
+
+  record("stats", Incanti::Stats::enabled ? "INCANTI_STATS=1" : "no stats",
+         "tokens", static_cast<size_t>(argc - 1), std::move(metrics));
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string format;
+  std::vector<std::string> only;
+
+  Incanti::Parser parser("incanti_bench", "Micro benchmarks for incanti");
+  parser >> arg("format", "f", &format) | def("table") |
+                "Output format: table, csv or json";
+  parser >> arg("only", "o", &only) |
+                "Run only these scenarios: lookup, registration, "
+                "parse_sealed, parse_argc, parse_forms, short_clusters, "
+                "response_file, config_file, conversion, units, list_values, "
+                "help, environment, startup, command_stream, shared_schema, "
+                "batch, errors, completion, commands, suggestions, "
+                "lazy, positionals, reload, allocations, stats";
+
+  parser.completion(); // the completion scenario spawns this binary
+  auto parsed = parser.try_parse(argc, argv);
+  if (parser.help_requested()) {
+    parser.print_help();
+    return 0;
+  }
+  if (!parsed) {
+    std::cerr << "Error: " << parsed.error().message << std::endl;
+    return 1;
+  }
+  if (format != "table" && format != "csv" && format != "json") {
+    std::cerr << "Error: Unknown format '" << format
+              << "', expected table, csv or json" << std::endl;
+    return 1;
+  }
+
+  const std::pair<const char *, void (*)()> scenarios[] = {
+      {"lookup", bench_lookup},
+      {"registration", bench_registration},
+      {"parse_sealed", bench_sealed_parse},
+      {"parse_argc", bench_argc},
+      {"parse_forms", bench_forms},
+      {"short_clusters", bench_clusters},
+      {"response_file", bench_response_file},
+      {"config_file", bench_config},
+      {"conversion", bench_conversion},
+      {"units", bench_units},
+      {"list_values", bench_list},
+      {"help", bench_help},
+      {"environment", bench_environment},
+      {"startup", bench_startup},
+      {"command_stream", bench_command_stream},
+      {"shared_schema", bench_shared_schema},
+      {"batch", bench_batch},
+      {"errors", bench_errors},
+      {"completion", bench_completion},
+      {"commands", bench_commands},
+      {"suggestions", bench_suggestions},
+      {"lazy", bench_lazy},
+      {"positionals", bench_positionals},
+      {"reload", bench_reload},
+      {"allocations", bench_allocations},
+      {"stats", bench_stats}};
+
+  for (const auto &scenario : scenarios) {
+    if (only.empty() ||
+        std::find(only.begin(), only.end(), scenario.first) != only.end()) {
+      scenario.second();
+    }
+  }
+
+  if (format == "csv") {
+    print_csv();
+  } else if (format == "json") {
+    print_json();
+  } else {
+    print_table();
+  }
+  return 0;
+}
@@ -25,116 +25,124 @@ int main(int argc, char *argv[]) {
   bool force = false;
   bool dry_run = false;
 
-  try {
-    // required argument like this
-    parser >> arg("input", "i", &input_file)
-      | required
-      | "Input file path";
-
-    // optional with default value
-    parser >> arg("output", "o", &output_file)
-      | "output file path"
-      | def("output.txt");
-
-    // custom converter (uppercase) like this
-    parser >> arg("mode", "m", &mode)
-      | "Processing mode (fast/slow/balanced)"
-      | def("balanced")
-      | [](const std::string &s) {
-        std::string upper = s;
-        std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-        if (upper != "FAST" && upper != "SLOW" && upper != "BALANCED") {
-          throw Incanti::ParseError("Mode must be fast, slow, or balanced");
+  // required argument like this
+  parser >> arg("input", "i", &input_file)
+    | required
+    | "Input file path";
+
+  // optional with default value
+  parser >> arg("output", "o", &output_file)
+    | "output file path"
+    | def("output.txt");
+
+  // custom converter (uppercase) like this; it accepts any case, which
+  // choices() would not. Converters reject a value by returning
+  // Incanti::unexpected(), no throw needed
+  parser >> arg("mode", "m", &mode)
+    | "Processing mode (fast/slow/balanced)"
+    | def("balanced")
+    | [](const std::string &s) -> Incanti::Expected<std::string> {
+      std::string upper = s;
+      std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+      if (upper != "FAST" && upper != "SLOW" && upper != "BALANCED") {
+        return Incanti::unexpected("Mode must be fast, slow, or balanced");
+      }
+      return upper;
+    };
+
+  parser >> arg("threads", "th", &threads)
+      | "Number of worker threads"
+      | def(4);
+
+  // custom range validation
+  parser >> arg("threshold", &threshold)
+      | "Confidence threshold (0.0-1.0)"
+      | def(0.5)
+      | [](const std::string &s) -> Incanti::Expected<double> {
+        double val = 0.0;
+        if (!Incanti::parse_number(s, val) || val < 0.0 || val > 1.0) {
+          return Incanti::unexpected("Threshold must be between 0.0 and 1.0");
         }
-        return upper;
+        return val;
       };
 
-    parser >> arg("threads", "th", &threads)
-        | "Number of worker threads"
-        | def(4);
-
-    // custom range validation
-    parser >> arg("threshold", &threshold)
-        | "Confidence threshold (0.0-1.0)"
-        | def(0.5)
-        | [](const std::string &s) {
-          double val = std::stod(s);
-          if (val < 0.0 || val > 1.0) {
-            throw Incanti::ParseError("Threshold must be between 0.0 and 1.0");
-          }
-          return val;
-        };
-
-    parser >> arg("scale", "s", &scale)
-      | "Scaling factor"
-      | def(1.0f);
-
-    // flags
-    parser >> flag("verbose", "v", &verbose)
-      | "Enable verbose output";
-
-    parser >> flag("debug", "d", &debug)
-      | "Enable debug mode";
-
-    parser >> flag("force", "f", &force)
-      | "Force overwrite existing files";
-
-    parser >> flag("dry-run", "n", &dry_run)
-      | "Perform a dry run without making changes";
-
-    // call parse to parse arguments
-    parser.parse(argc, argv);
-
-    std::cout << "\n" << std::string(50, '=') << std::endl;
-    std::cout << "PARSED ARGUMENTS" << std::endl;
-    std::cout << std::string(50, '=') << std::endl;
-
-    std::cout << "\nString Arguments:" << std::endl;
-    std::cout << "  Input:       " << input_file << std::endl;
-    std::cout << "  Output:      " << output_file << std::endl;
-    std::cout << "  Mode:        " << mode << std::endl;
-
-    std::cout << "\nNumeric Arguments:" << std::endl;
-    std::cout << "  Threads:     " << threads << std::endl;
-    std::cout << "  Threshold:   " << std::fixed << std::setprecision(2)
-              << threshold << std::endl;
-    std::cout << "  Scale:       " << scale << std::endl;
-
-    std::cout << "\nFlags:" << std::endl;
-    std::cout << "  Verbose:     " << (verbose ? "yes" : "no") << std::endl;
-    std::cout << "  Debug:       " << (debug ? "yes" : "no") << std::endl;
-    std::cout << "  Force:       " << (force ? "yes" : "no") << std::endl;
-    std::cout << "  Dry Run:     " << (dry_run ? "yes" : "no") << std::endl;
-
-    const auto &positional = parser.positional();
-    if (!positional.empty()) {
-      std::cout << "\nPositional Arguments:" << std::endl;
-      for (size_t i = 0; i < positional.size(); ++i) {
-        std::cout << "  [" << i << "] " << positional[i] << std::endl;
-      }
-    }
+  parser >> arg("scale", "s", &scale)
+    | "Scaling factor"
+    | def(1.0f);
 
-    std::cout << "\n" << std::string(50, '=') << std::endl;
+  // flags
+  parser >> flag("verbose", "v", &verbose)
+    | "Enable verbose output";
 
-    std::cout << "\nProcessing with configuration:" << std::endl;
-    std::cout << "  Reading from: " << input_file << std::endl;
-    std::cout << "  Writing to:   " << output_file << std::endl;
-    std::cout << "  Mode:         " << mode << std::endl;
-    std::cout << "  Using " << threads << " threads" << std::endl;
+  parser >> flag("debug", "d", &debug)
+    | "Enable debug mode";
 
-    if (dry_run) {
-      std::cout << "\n[DRY RUN] No changes were made." << std::endl;
-    } else if (verbose) {
-      std::cout << "\n[VERBOSE] Processing complete!" << std::endl;
-    }
+  parser >> flag("force", "f", &force)
+    | "Force overwrite existing files";
+
+  parser >> flag("dry-run", "n", &dry_run)
+    | "Perform a dry run without making changes";
 
-  } catch (const Incanti::ParseError &e) {
-    std::cerr << "\nError: " << e.what() << "\n" << std::endl;
+  // expand @file arguments from response files
+  parser.response_files();
+
+  // answer `incanti-demo __complete ...` for the shell completion scripts
+  parser.completion();
+
+  // call parse to parse arguments; try_parse() hands a bad command line
+  // back instead of throwing, so the demo builds with -fno-exceptions too
+  auto parsed = parser.try_parse(argc, argv);
+  if (parser.help_requested()) {
+    parser.print_help();
+    return 0;
+  }
+  if (!parsed) {
+    std::cerr << "\nError: " << parsed.error().message << "\n" << std::endl;
     parser.print_help();
     return 1;
-  } catch (const std::exception &e) {
-    std::cerr << "\nUnexpected error: " << e.what() << std::endl;
-    return 1;
+  }
+
+  std::cout << "\n" << std::string(50, '=') << std::endl;
+  std::cout << "PARSED ARGUMENTS" << std::endl;
+  std::cout << std::string(50, '=') << std::endl;
+
+  std::cout << "\nString Arguments:" << std::endl;
+  std::cout << "  Input:       " << input_file << std::endl;
+  std::cout << "  Output:      " << output_file << std::endl;
+  std::cout << "  Mode:        " << mode << std::endl;
+
+  std::cout << "\nNumeric Arguments:" << std::endl;
+  std::cout << "  Threads:     " << threads << std::endl;
+  std::cout << "  Threshold:   " << std::fixed << std::setprecision(2)
+            << threshold << std::endl;
+  std::cout << "  Scale:       " << scale << std::endl;
+
+  std::cout << "\nFlags:" << std::endl;
+  std::cout << "  Verbose:     " << (verbose ? "yes" : "no") << std::endl;
+  std::cout << "  Debug:       " << (debug ? "yes" : "no") << std::endl;
+  std::cout << "  Force:       " << (force ? "yes" : "no") << std::endl;
+  std::cout << "  Dry Run:     " << (dry_run ? "yes" : "no") << std::endl;
+
+  const auto &positional = parser.positional();
+  if (!positional.empty()) {
+    std::cout << "\nPositional Arguments:" << std::endl;
+    for (size_t i = 0; i < positional.size(); ++i) {
+      std::cout << "  [" << i << "] " << positional[i] << std::endl;
+    }
+  }
+
+  std::cout << "\n" << std::string(50, '=') << std::endl;
+
+  std::cout << "\nProcessing with configuration:" << std::endl;
+  std::cout << "  Reading from: " << input_file << std::endl;
+  std::cout << "  Writing to:   " << output_file << std::endl;
+  std::cout << "  Mode:         " << mode << std::endl;
+  std::cout << "  Using " << threads << " threads" << std::endl;
+
+  if (dry_run) {
+    std::cout << "\n[DRY RUN] No changes were made." << std::endl;
+  } else if (verbose) {
+    std::cout << "\n[VERBOSE] Processing complete!" << std::endl;
   }
 
   return 0;